@@ -0,0 +1,302 @@
+#ifndef BUFFER_STORE_HPP
+#define BUFFER_STORE_HPP
+/* BufferStore.hpp
+ *
+ * compact storage for the texts of inactive editor buffers, in a shared
+ * pool of pages with a fixed memory budget
+ */
+
+#include <algorithm>  // std::min
+#include <cstddef>    // std::size_t
+#include <cstdint>    // std::uint64_t
+#include <cstdio>     // std::FILE, std::tmpfile
+#include <cstring>    // std::memcpy
+#include <iterator>   // std::prev
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <unistd.h>  // ftruncate
+
+class BufferStore {
+    // OVERVIEW: a store of texts, each packed into fixed-size pages that
+    //           are shared by all of them. At most budget bytes of pages
+    //           are ever allocated: when storing a text needs more, the
+    //           least recently used texts are evicted to a temporary
+    //           file, and are read back when they are next taken. A text
+    //           larger than the whole budget is written to the file
+    //           directly. Each text keeps its extent of the file for its
+    //           next eviction; an extent too small for it is freed, and
+    //           free extents are reused (first fit, merged with free
+    //           neighbours) before the file grows. The file is truncated
+    //           when its end is freed, so it does not grow without bound
+    //           as evicted texts grow.
+   public:
+    static constexpr std::size_t PAGE_SIZE = 16384;  // bytes per page
+
+    // EFFECTS: Creates an empty store that keeps at most budget bytes of
+    //          text in memory, rounded down to a whole number of pages.
+    explicit BufferStore(std::size_t budget) : max_pages(budget / PAGE_SIZE), use_count(0) {}
+
+    // disable copying
+    BufferStore(const BufferStore &) = delete;
+    BufferStore &operator=(const BufferStore &) = delete;
+
+    ~BufferStore() {
+        if (spill_file) {
+            std::fclose(spill_file);  // a tmpfile is deleted when closed
+        }
+    }
+
+    // MODIFIES: *this
+    // EFFECTS:  Stores the given text and returns its id. Throws
+    //           std::runtime_error if a text cannot be evicted.
+    int add(std::string_view text) {
+        entries.emplace_back();
+        put(entries.size() - 1, text);
+        return entries.size() - 1;
+    }
+
+    // REQUIRES: id was returned by add
+    // MODIFIES: *this
+    // EFFECTS:  Replaces the text with the given id. Throws
+    //           std::runtime_error if a text cannot be evicted.
+    void put(int id, std::string_view text) {
+        Entry &entry = entries[id];
+        release_pages(entry);
+        entry.size = text.size();
+        entry.last_use = ++use_count;
+        std::size_t needed = pages_for(text.size());
+        if (needed > max_pages) {
+            write_to_disk(entry, text);
+            return;
+        }
+        make_room(needed, id);
+        for (std::size_t offset = 0; offset < text.size(); offset += PAGE_SIZE) {
+            int page = allocate_page();
+            std::size_t length = std::min(PAGE_SIZE, text.size() - offset);
+            std::memcpy(pages[page].get(), text.data() + offset, length);
+            entry.pages.push_back(page);
+        }
+        entry.resident = true;
+    }
+
+    // REQUIRES: id was returned by add
+    // MODIFIES: *this
+    // EFFECTS:  Returns the text with the given id, reading it back from
+    //           the temporary file if it was evicted, and releases the
+    //           pages it used. The id keeps an empty text until the next
+    //           put. Throws std::runtime_error if the text cannot be read.
+    std::string take(int id) {
+        Entry &entry = entries[id];
+        std::string text;
+        if (entry.resident) {
+            text = gather(entry);
+            release_pages(entry);
+        } else if (entry.size > 0) {
+            text.resize(entry.size);
+            if (std::fseek(spill_file, entry.disk_offset, SEEK_SET) != 0 ||
+                std::fread(&text[0], 1, text.size(), spill_file) != text.size()) {
+                throw std::runtime_error("Unable to read an evicted buffer");
+            }
+        }
+        entry.size = 0;
+        entry.resident = true;
+        entry.last_use = ++use_count;
+        return text;
+    }
+
+    // EFFECTS: Returns the number of bytes in the text with the given id.
+    std::size_t size(int id) const {
+        return entries[id].size;
+    }
+
+    // EFFECTS: Returns whether the text with the given id is held in the
+    //          temporary file rather than in memory.
+    bool evicted(int id) const {
+        return !entries[id].resident;
+    }
+
+    // EFFECTS: Returns the number of pages that hold text.
+    std::size_t pages_in_use() const {
+        return pages.size() - free_pages.size();
+    }
+
+    // EFFECTS: Returns the number of pages allocated, which is never
+    //          more than the budget.
+    std::size_t pages_allocated() const {
+        return pages.size();
+    }
+
+    // EFFECTS: Returns the size in bytes of the temporary file.
+    std::size_t disk_size() const {
+        return file_size;
+    }
+
+    // EFFECTS: Returns the number of pages the budget allows.
+    std::size_t page_budget() const {
+        return max_pages;
+    }
+
+   private:
+    struct Entry {
+        std::vector<int> pages;      // in order, the last possibly partly filled
+        std::size_t size = 0;        // bytes in the text
+        bool resident = true;        // whether the text is in pages rather than on disk
+        long disk_offset = -1;       // extent in the temporary file, -1 if none
+        std::size_t disk_capacity = 0;
+        std::uint64_t last_use = 0;  // use_count when last stored or taken
+    };
+
+    std::size_t max_pages;
+    std::vector<std::unique_ptr<char[]>> pages;
+    std::vector<int> free_pages;
+    std::vector<Entry> entries;  // indexed by id
+    std::uint64_t use_count;
+    std::FILE *spill_file = nullptr;  // created on the first eviction
+    long spill_size = 0;              // end of the last extent in use
+    long file_size = 0;               // of spill_file, at least spill_size
+    std::map<long, std::size_t> free_extents;  // capacity of each, by offset
+
+    static std::size_t pages_for(std::size_t size) {
+        return (size + PAGE_SIZE - 1) / PAGE_SIZE;
+    }
+
+    // MODIFIES: *this
+    // EFFECTS:  Returns a free page, allocating one if there are none.
+    int allocate_page() {
+        if (free_pages.empty()) {
+            pages.push_back(std::make_unique<char[]>(PAGE_SIZE));
+            return pages.size() - 1;
+        }
+        int page = free_pages.back();
+        free_pages.pop_back();
+        return page;
+    }
+
+    // MODIFIES: *this, entry
+    // EFFECTS:  Returns the pages of the given entry to the free list.
+    void release_pages(Entry &entry) {
+        free_pages.insert(free_pages.end(), entry.pages.begin(), entry.pages.end());
+        entry.pages.clear();
+    }
+
+    // REQUIRES: needed <= max_pages
+    // MODIFIES: *this
+    // EFFECTS:  Evicts the least recently used texts, other than the one
+    //           with the given id, until needed more pages can be
+    //           allocated within the budget.
+    void make_room(std::size_t needed, int id) {
+        while (pages_in_use() + needed > max_pages) {
+            Entry *oldest = nullptr;
+            for (std::size_t i = 0; i < entries.size(); ++i) {
+                Entry &entry = entries[i];
+                if (int(i) != id && !entry.pages.empty() &&
+                    (!oldest || entry.last_use < oldest->last_use)) {
+                    oldest = &entry;
+                }
+            }
+            evict(*oldest);
+        }
+    }
+
+    // MODIFIES: *this, entry
+    // EFFECTS:  Moves the text of the given entry to the temporary file.
+    void evict(Entry &entry) {
+        write_to_disk(entry, gather(entry));
+        release_pages(entry);
+    }
+
+    // EFFECTS: Returns the text held in the pages of the given entry.
+    std::string gather(const Entry &entry) const {
+        std::string text(entry.size, '\0');
+        for (std::size_t i = 0; i < entry.pages.size(); ++i) {
+            std::size_t offset = i * PAGE_SIZE;
+            std::memcpy(&text[offset], pages[entry.pages[i]].get(),
+                        std::min(PAGE_SIZE, text.size() - offset));
+        }
+        return text;
+    }
+
+    // MODIFIES: *this, entry
+    // EFFECTS:  Writes the given text to the entry's extent of the
+    //           temporary file, or if it does not fit there, frees that
+    //           extent and writes it to a new one, and marks the entry as
+    //           evicted. Truncates the file if its end is now free. Throws
+    //           std::runtime_error if the file cannot be written.
+    void write_to_disk(Entry &entry, std::string_view text) {
+        if (!spill_file && !(spill_file = std::tmpfile())) {
+            throw std::runtime_error("Unable to create a file for evicted buffers");
+        }
+        if (entry.disk_offset < 0 || entry.disk_capacity < text.size()) {
+            if (entry.disk_offset >= 0) {
+                free_extent(entry.disk_offset, entry.disk_capacity);
+            }
+            entry.disk_offset = allocate_extent(text.size());
+            entry.disk_capacity = text.size();
+        }
+        if (std::fseek(spill_file, entry.disk_offset, SEEK_SET) != 0 ||
+            std::fwrite(text.data(), 1, text.size(), spill_file) != text.size() ||
+            std::fflush(spill_file) != 0) {
+            throw std::runtime_error("Unable to evict a buffer");
+        }
+        entry.resident = false;
+        file_size = std::max(file_size, spill_size);
+        if (file_size > spill_size && ftruncate(fileno(spill_file), spill_size) == 0) {
+            file_size = spill_size;  // a failure only leaves the file larger
+        }
+    }
+
+    // MODIFIES: *this
+    // EFFECTS:  Returns the offset of an extent of the temporary file
+    //           with room for size bytes, taking it from the first free
+    //           extent that is large enough, or else from the end.
+    long allocate_extent(std::size_t size) {
+        for (auto it = free_extents.begin(); it != free_extents.end(); ++it) {
+            if (it->second >= size) {
+                long offset = it->first;
+                std::size_t rest = it->second - size;
+                free_extents.erase(it);
+                if (rest > 0) {
+                    free_extents[offset + size] = rest;
+                }
+                return offset;
+            }
+        }
+        long offset = spill_size;
+        spill_size += size;
+        return offset;
+    }
+
+    // MODIFIES: *this
+    // EFFECTS:  Frees the given extent of the temporary file, merging it
+    //           with any free extents next to it.
+    void free_extent(long offset, std::size_t capacity) {
+        if (capacity == 0) {
+            return;
+        }
+        auto next = free_extents.lower_bound(offset);
+        if (next != free_extents.begin()) {
+            auto previous = std::prev(next);
+            if (previous->first + long(previous->second) == offset) {
+                offset = previous->first;
+                capacity += previous->second;
+                free_extents.erase(previous);
+            }
+        }
+        if (next != free_extents.end() && offset + long(capacity) == next->first) {
+            capacity += next->second;
+            free_extents.erase(next);
+        }
+        if (offset + long(capacity) == spill_size) {
+            spill_size = offset;  // the end of the file is free, so reuse it as the end
+        } else {
+            free_extents[offset] = capacity;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,124 @@
+#include "BufferStore.hpp"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "unit_test_framework.hpp"
+
+using namespace std;
+
+// Helpers
+string text_of(int id, size_t size);
+
+TEST(test_put_and_take) {
+    BufferStore store(4 * BufferStore::PAGE_SIZE);
+    string text = text_of(1, BufferStore::PAGE_SIZE + 10);
+    int id = store.add(text);
+    ASSERT_EQUAL(store.size(id), text.size());
+    ASSERT_FALSE(store.evicted(id));
+    ASSERT_EQUAL(store.pages_in_use(), 2u);
+    ASSERT_TRUE(store.take(id) == text);
+    ASSERT_EQUAL(store.pages_in_use(), 0u);  // taken texts release their pages
+    ASSERT_EQUAL(store.size(id), 0u);
+    store.put(id, "short");
+    ASSERT_EQUAL(store.take(id), "short");
+    int empty = store.add("");
+    ASSERT_EQUAL(store.take(empty), "");
+}
+
+TEST(test_pages_are_reused) {
+    BufferStore store(4 * BufferStore::PAGE_SIZE);
+    int first = store.add(text_of(1, 3 * BufferStore::PAGE_SIZE));
+    store.take(first);
+    int second = store.add(text_of(2, 2 * BufferStore::PAGE_SIZE));
+    ASSERT_EQUAL(store.pages_in_use(), 2u);
+    ASSERT_EQUAL(store.pages_allocated(), 3u);
+    ASSERT_TRUE(store.take(second) == text_of(2, 2 * BufferStore::PAGE_SIZE));
+}
+
+TEST(test_evicts_least_recently_used) {
+    const size_t SIZE = BufferStore::PAGE_SIZE + 1;  // two pages each
+    BufferStore store(5 * BufferStore::PAGE_SIZE);
+    int a = store.add(text_of(1, SIZE));
+    int b = store.add(text_of(2, SIZE));
+    ASSERT_TRUE(store.take(a) == text_of(1, SIZE));
+    store.put(a, text_of(3, SIZE));  // now b is the least recently used
+    int c = store.add(text_of(4, SIZE));
+    ASSERT_TRUE(store.evicted(b));
+    ASSERT_FALSE(store.evicted(a));
+    ASSERT_FALSE(store.evicted(c));
+    ASSERT_TRUE(store.pages_in_use() <= store.page_budget());
+    ASSERT_TRUE(store.take(b) == text_of(2, SIZE));  // read back from disk
+    store.put(b, text_of(5, SIZE));  // evicts a
+    ASSERT_TRUE(store.evicted(a));
+    ASSERT_TRUE(store.take(a) == text_of(3, SIZE));
+    ASSERT_TRUE(store.take(b) == text_of(5, SIZE));
+    ASSERT_TRUE(store.take(c) == text_of(4, SIZE));
+}
+
+TEST(test_text_larger_than_budget) {
+    BufferStore store(2 * BufferStore::PAGE_SIZE);
+    int small = store.add("small");
+    string large = text_of(7, 3 * BufferStore::PAGE_SIZE);
+    int id = store.add(large);
+    ASSERT_TRUE(store.evicted(id));
+    ASSERT_FALSE(store.evicted(small));
+    ASSERT_EQUAL(store.pages_allocated(), 1u);
+    ASSERT_TRUE(store.take(id) == large);
+    ASSERT_EQUAL(store.take(small), "small");
+}
+
+TEST(test_many_texts_within_budget) {
+    // a hundred texts with a budget for a few of them
+    BufferStore store(8 * BufferStore::PAGE_SIZE);
+    vector<int> ids;
+    for (int i = 0; i < 100; ++i) {
+        ids.push_back(store.add(text_of(i, 1000 + i * 300)));
+        ASSERT_TRUE(store.pages_allocated() <= store.page_budget());
+    }
+    for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < 100; i += 7) {
+            string text = store.take(ids[i]);
+            ASSERT_TRUE(text == text_of(i + round * 100, text.size()));
+            // grow or shrink it, so that it sometimes needs a new extent
+            store.put(ids[i], text_of(i + (round + 1) * 100, text.size() + (i % 2 ? 5000 : -9)));
+            ASSERT_TRUE(store.pages_allocated() <= store.page_budget());
+        }
+    }
+    for (int i = 0; i < 100; ++i) {
+        size_t size = 1000 + i * 300 + (i % 7 ? 0 : 3 * (i % 2 ? 5000 : -9));
+        ASSERT_TRUE(store.take(ids[i]) == text_of(i + (i % 7 ? 0 : 300), size));
+    }
+}
+
+TEST(test_disk_extents_are_reused) {
+    // two texts, only one of which fits, evicting each other as they grow
+    BufferStore store(3 * BufferStore::PAGE_SIZE);
+    size_t size = BufferStore::PAGE_SIZE + 1;  // two pages each
+    int a = store.add(text_of(1, size));
+    int b = store.add(text_of(2, size));
+    size_t largest = 0;
+    for (int round = 0; round < 20; ++round) {
+        size += 500;
+        store.put(a, text_of(round, size));  // evicts b
+        store.put(b, text_of(round + 1, size));  // evicts a, which has grown
+        ASSERT_TRUE(store.disk_size() <= 3 * size);
+        largest = max(largest, store.disk_size());
+    }
+    ASSERT_TRUE(store.disk_size() < largest);  // the file was truncated
+    ASSERT_TRUE(store.evicted(a));
+    ASSERT_TRUE(store.take(a) == text_of(19, size));
+    ASSERT_TRUE(store.take(b) == text_of(20, size));
+}
+
+// Returns a text of the given size whose bytes depend on the given id.
+string text_of(int id, size_t size) {
+    string text;
+    for (size_t i = 0; i < size; ++i) {
+        text.push_back(i % 80 == 79 ? '\n' : char('!' + (id * 7 + i) % 90));
+    }
+    return text;
+}
+
+TEST_MAIN()
@@ -0,0 +1,234 @@
+#ifndef CONCURRENT_LIST_HPP
+#define CONCURRENT_LIST_HPP
+/* ConcurrentList.hpp
+ *
+ * lock-free queue that many threads can push to the back of and pop from
+ * the front of at once
+ */
+
+#include <algorithm>  // std::sort, std::binary_search
+#include <atomic>
+#include <cstddef>  // std::size_t
+#include <new>      // placement new
+#include <utility>  // std::move
+#include <vector>
+
+template <typename T>
+class ConcurrentList {
+    // OVERVIEW: a FIFO queue with the push_back and pop_front of List,
+    //           safe to use from any number of threads at once without
+    //           locks. It is a Michael-Scott queue: a singly-linked list
+    //           that always starts with a dummy node, whose head and tail
+    //           are moved with compare-and-swap. A popped node is freed
+    //           only once no thread holds a hazard pointer to it, so a
+    //           thread never reads a node that another has freed.
+   public:
+    ConcurrentList() : records(nullptr), record_count(0) {
+        Node *dummy = new Node;
+        head.store(dummy);
+        tail.store(dummy);
+    }
+
+    // disable copying
+    ConcurrentList(const ConcurrentList &) = delete;
+    ConcurrentList &operator=(const ConcurrentList &) = delete;
+
+    // REQUIRES: no other thread is using the list
+    ~ConcurrentList() {
+        Node *dummy = head.load();
+        for (Node *node = dummy->next.load(); node;) {
+            Node *next = node->next.load();
+            node->datum()->~T();
+            delete node;
+            node = next;
+        }
+        delete dummy;
+        for (HazardRecord *record = records.load(); record;) {
+            HazardRecord *next = record->next;
+            for (Node *node : record->retired) {
+                delete node;
+            }
+            delete record;
+            record = next;
+        }
+    }
+
+    // EFFECTS: Inserts a copy of datum at the back of the list.
+    void push_back(const T &datum) {
+        Node *node = new Node;
+        try {
+            ::new (static_cast<void *>(node->storage)) T(datum);
+        } catch (...) {
+            delete node;
+            throw;
+        }
+        HazardRecord *record = acquire_record();
+        while (true) {
+            Node *last = protect(record->hazards[0], tail);
+            Node *next = last->next.load();
+            if (last != tail.load()) {
+                continue;
+            }
+            if (next) {  // the tail is behind, so help move it along
+                tail.compare_exchange_weak(last, next);
+                continue;
+            }
+            if (last->next.compare_exchange_weak(next, node)) {
+                tail.compare_exchange_strong(last, node);
+                break;
+            }
+        }
+        release_record(record);
+    }
+
+    // MODIFIES: datum
+    // EFFECTS:  Moves the element at the front of the list into datum and
+    //           removes it, or returns false if the list is empty. If
+    //           moving the element throws, it is lost.
+    bool try_pop_front(T &datum) {
+        HazardRecord *record = acquire_record();
+        while (true) {
+            Node *first = protect(record->hazards[0], head);
+            Node *last = tail.load();
+            Node *next = first->next.load();
+            record->hazards[1].store(next);
+            if (first != head.load()) {  // then next may not be protected
+                continue;
+            }
+            if (!next) {
+                release_record(record);
+                return false;
+            }
+            if (first == last) {  // the tail is behind, so help move it along
+                tail.compare_exchange_weak(last, next);
+                continue;
+            }
+            if (head.compare_exchange_weak(first, next)) {
+                // next is now the dummy, and its element is ours alone
+                record->hazards[0].store(nullptr, std::memory_order_release);
+                retire(record, first);
+                T *element = next->datum();
+                try {
+                    datum = std::move(*element);
+                } catch (...) {
+                    element->~T();
+                    release_record(record);
+                    throw;
+                }
+                element->~T();
+                release_record(record);
+                return true;
+            }
+        }
+    }
+
+    // EFFECTS: Returns whether the list was empty at some moment during
+    //          the call.
+    bool empty() const {
+        HazardRecord *record = acquire_record();
+        bool result = !protect(record->hazards[0], head)->next.load();
+        release_record(record);
+        return result;
+    }
+
+   private:
+    struct Node {
+        std::atomic<Node *> next{nullptr};
+        alignas(T) unsigned char storage[sizeof(T)];  // the element, unless a dummy
+
+        T *datum() {
+            return std::launder(reinterpret_cast<T *>(storage));
+        }
+    };
+
+    // The hazard pointers of one thread at a time, and the nodes it
+    // removed that may still be in use by others. Records are never
+    // freed before the list, and are reused by later operations.
+    struct alignas(64) HazardRecord {  // one per cache line, to avoid false sharing
+        std::atomic<Node *> hazards[2] = {};
+        std::atomic<bool> active{true};
+        HazardRecord *next = nullptr;  // the next record, never changed once published
+        std::vector<Node *> retired;
+        std::vector<Node *> in_use;  // reused by each scan of the hazard pointers
+    };
+
+    static constexpr std::size_t MIN_RETIRED = 64;  // nodes to retire before each scan
+
+    alignas(64) std::atomic<Node *> head;  // the dummy node
+    alignas(64) std::atomic<Node *> tail;  // the last node, or shortly before it
+    alignas(64) mutable std::atomic<HazardRecord *> records;
+    mutable std::atomic<std::size_t> record_count;
+
+    // EFFECTS: Claims a record that is not in use, adding one if there
+    //          are none.
+    HazardRecord *acquire_record() const {
+        for (HazardRecord *record = records.load(); record; record = record->next) {
+            if (!record->active.load() && !record->active.exchange(true)) {
+                return record;
+            }
+        }
+        HazardRecord *record = new HazardRecord;
+        record->next = records.load();
+        while (!records.compare_exchange_weak(record->next, record)) {
+        }
+        ++record_count;
+        return record;
+    }
+
+    // EFFECTS: Clears the hazard pointers of the given record and gives
+    //          it up. Only setting a hazard pointer needs to be ordered
+    //          before later loads; clearing one can be seen late.
+    static void release_record(HazardRecord *record) {
+        record->hazards[0].store(nullptr, std::memory_order_release);
+        record->hazards[1].store(nullptr, std::memory_order_release);
+        record->active.store(false, std::memory_order_release);
+    }
+
+    // MODIFIES: hazard
+    // EFFECTS:  Sets the hazard pointer to the node that source points to,
+    //           and returns the node, which cannot be freed until the
+    //           hazard pointer changes.
+    static Node *protect(std::atomic<Node *> &hazard, const std::atomic<Node *> &source) {
+        Node *node = source.load();
+        while (true) {
+            hazard.store(node);
+            Node *current = source.load();  // still reachable after the hazard is seen
+            if (current == node) {
+                return node;
+            }
+            node = current;
+        }
+    }
+
+    // REQUIRES: node has been removed from the list
+    // MODIFIES: record
+    // EFFECTS:  Frees node once no hazard pointer points to it, along with
+    //           any earlier retired nodes that are also no longer in use.
+    void retire(HazardRecord *record, Node *node) {
+        record->retired.push_back(node);
+        if (record->retired.size() < MIN_RETIRED + 4 * record_count.load()) {
+            return;
+        }
+        std::vector<Node *> &in_use = record->in_use;
+        in_use.clear();
+        for (HazardRecord *other = records.load(); other; other = other->next) {
+            for (const std::atomic<Node *> &hazard : other->hazards) {
+                if (Node *protected_node = hazard.load()) {
+                    in_use.push_back(protected_node);
+                }
+            }
+        }
+        std::sort(in_use.begin(), in_use.end());
+        std::size_t kept = 0;
+        for (Node *retired : record->retired) {
+            if (std::binary_search(in_use.begin(), in_use.end(), retired)) {
+                record->retired[kept++] = retired;
+            } else {
+                delete retired;
+            }
+        }
+        record->retired.resize(kept);
+    }
+};
+
+#endif
@@ -0,0 +1,83 @@
+#include "ConcurrentList.hpp"
+
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "List.hpp"
+#include "unit_test_framework.hpp"
+
+using namespace std;
+
+const int PAIRS = 10000;  // pushes and pops by each thread per iteration
+
+// A List shared by wrapping it in a mutex, to compare against.
+class LockedList {
+   public:
+    void push_back(int datum) {
+        lock_guard<mutex> lock(list_mutex);
+        list_int.push_back(datum);
+    }
+
+    bool try_pop_front(int &datum) {
+        lock_guard<mutex> lock(list_mutex);
+        if (list_int.empty()) {
+            return false;
+        }
+        datum = list_int.front();
+        list_int.pop_front();
+        return true;
+    }
+
+   private:
+    mutex list_mutex;
+    List<int> list_int;
+};
+
+// Helpers
+template <typename Queue>
+void run_pairs(BenchState &state, int threads);
+
+// Each thread alternately pushes to the back of a shared queue and pops
+// from its front, with 1 to 32 threads.
+#define QUEUE_BENCHES(threads)                                    \
+    BENCH(bench_locked_list_##threads) {                          \
+        run_pairs<LockedList>(state, threads);                    \
+    }                                                             \
+    BENCH(bench_concurrent_list_##threads) {                      \
+        run_pairs<ConcurrentList<int>>(state, threads);           \
+    }
+
+QUEUE_BENCHES(1)
+QUEUE_BENCHES(2)
+QUEUE_BENCHES(4)
+QUEUE_BENCHES(8)
+QUEUE_BENCHES(16)
+QUEUE_BENCHES(32)
+
+template <typename Queue>
+void run_pairs(BenchState &state, int threads) {
+    state.set_items_per_iteration(2.0 * PAIRS * threads);
+    while (state.keep_running()) {
+        Queue queue;
+        vector<thread> workers;
+        for (int t = 0; t < threads; ++t) {
+            workers.emplace_back([&queue]() {
+                long sum = 0;
+                for (int i = 0; i < PAIRS; ++i) {
+                    queue.push_back(i);
+                    int datum;
+                    if (queue.try_pop_front(datum)) {
+                        sum += datum;
+                    }
+                }
+                DoNotOptimize(sum);
+            });
+        }
+        for (thread &worker : workers) {
+            worker.join();
+        }
+    }
+}
+
+TEST_MAIN()
@@ -0,0 +1,81 @@
+#include "ConcurrentList.hpp"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "unit_test_framework.hpp"
+
+using namespace std;
+
+TEST(test_fifo_order) {
+    ConcurrentList<int> list_int;
+    int datum = -1;
+    ASSERT_TRUE(list_int.empty());
+    ASSERT_FALSE(list_int.try_pop_front(datum));
+    ASSERT_EQUAL(datum, -1);
+    for (int i = 0; i < 200; ++i) {  // enough to free retired nodes
+        list_int.push_back(i);
+    }
+    ASSERT_FALSE(list_int.empty());
+    for (int i = 0; i < 200; ++i) {
+        ASSERT_TRUE(list_int.try_pop_front(datum));
+        ASSERT_EQUAL(datum, i);
+    }
+    ASSERT_TRUE(list_int.empty());
+}
+
+TEST(test_destroys_remaining_elements) {
+    ConcurrentList<string> list_str;
+    list_str.push_back(string(100, 'a'));  // too long to be stored inline
+    list_str.push_back(string(100, 'b'));
+    list_str.push_back(string(100, 'c'));
+    string datum;
+    ASSERT_TRUE(list_str.try_pop_front(datum));
+    ASSERT_EQUAL(datum, string(100, 'a'));
+}
+
+TEST(test_many_producers_and_consumers) {
+    const int THREADS = 4;
+    const int COUNT = 20000;  // pushed by each producer
+    ConcurrentList<int> list_int;
+    vector<vector<int>> popped(THREADS);
+    vector<thread> threads;
+    for (int t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&list_int, t]() {
+            for (int i = 0; i < COUNT; ++i) {
+                list_int.push_back(t * COUNT + i);
+            }
+        });
+        threads.emplace_back([&list_int, &popped, t]() {
+            for (int i = 0; i < COUNT;) {
+                int datum;
+                if (list_int.try_pop_front(datum)) {
+                    popped[t].push_back(datum);
+                    ++i;
+                }
+            }
+        });
+    }
+    for (thread &worker : threads) {
+        worker.join();
+    }
+    ASSERT_TRUE(list_int.empty());
+
+    // every element is popped once, and each consumer sees the elements
+    // of each producer in the order they were pushed
+    vector<int> times_popped(THREADS * COUNT);
+    for (const vector<int> &consumer : popped) {
+        vector<int> last(THREADS, -1);
+        for (int datum : consumer) {
+            ++times_popped[datum];
+            ASSERT_TRUE(datum > last[datum / COUNT]);
+            last[datum / COUNT] = datum;
+        }
+    }
+    for (int times : times_popped) {
+        ASSERT_EQUAL(times, 1);
+    }
+}
+
+TEST_MAIN()
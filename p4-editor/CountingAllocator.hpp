@@ -0,0 +1,108 @@
+#ifndef COUNTING_ALLOCATOR_HPP
+#define COUNTING_ALLOCATOR_HPP
+/* CountingAllocator.hpp
+ *
+ * allocator that counts the allocations and bytes of the containers
+ * that use it, for measuring memory use in tests and benchmarks
+ */
+
+#include <sys/resource.h>  // getrusage
+
+#include <algorithm>  // std::max
+#include <cstddef>    // std::size_t
+#include <memory>     // std::allocator
+
+// Running totals of the allocations made through some allocator.
+struct AllocationCounts {
+    long allocations = 0;
+    long deallocations = 0;
+    std::size_t total_bytes = 0;  // bytes ever allocated
+    std::size_t live_bytes = 0;   // bytes allocated and not yet deallocated
+    std::size_t peak_bytes = 0;   // largest value of live_bytes
+
+    // MODIFIES: *this
+    // EFFECTS:  Records an allocation of the given number of bytes.
+    void allocated(std::size_t bytes) {
+        ++allocations;
+        total_bytes += bytes;
+        live_bytes += bytes;
+        peak_bytes = std::max(peak_bytes, live_bytes);
+    }
+
+    // MODIFIES: *this
+    // EFFECTS:  Records a deallocation of the given number of bytes.
+    void deallocated(std::size_t bytes) {
+        ++deallocations;
+        live_bytes -= bytes;
+    }
+
+    // EFFECTS: Returns the counts shared by every CountingAllocator that
+    //          was not given its own.
+    static AllocationCounts &shared() {
+        static AllocationCounts counts;
+        return counts;
+    }
+};
+
+template <typename T>
+class CountingAllocator {
+    // OVERVIEW: a std::allocator that records each allocation and
+    //           deallocation in an AllocationCounts. Copies, including
+    //           those rebound to another type (such as a container's
+    //           node type), record in the same counts. Not thread safe.
+   public:
+    using value_type = T;
+
+    // EFFECTS: Creates an allocator that records in the given counts.
+    explicit CountingAllocator(AllocationCounts *counts_in = &AllocationCounts::shared())
+        : counts(counts_in) {}
+
+    template <typename U>
+    CountingAllocator(const CountingAllocator<U> &other) : counts(other.counts) {}
+
+    // EFFECTS: Returns the counts that this allocator records in.
+    AllocationCounts &get_counts() const {
+        return *counts;
+    }
+
+    T *allocate(std::size_t n) {
+        T *memory = std::allocator<T>().allocate(n);
+        counts->allocated(n * sizeof(T));
+        return memory;
+    }
+
+    void deallocate(T *memory, std::size_t n) {
+        counts->deallocated(n * sizeof(T));
+        std::allocator<T>().deallocate(memory, n);
+    }
+
+    template <typename U>
+    bool operator==(const CountingAllocator<U> &other) const {
+        return counts == other.counts;
+    }
+
+    template <typename U>
+    bool operator!=(const CountingAllocator<U> &other) const {
+        return counts != other.counts;
+    }
+
+   private:
+    template <typename U>
+    friend class CountingAllocator;
+
+    AllocationCounts *counts;
+};
+
+// EFFECTS: Returns the largest amount of memory that this process has
+//          had resident, in bytes.
+inline std::size_t peak_resident_bytes() {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss;  // already in bytes
+#else
+    return usage.ru_maxrss * std::size_t(1024);  // in kilobytes
+#endif
+}
+
+#endif
@@ -1,23 +1,75 @@
 #ifndef EDITOR_HPP
 #define EDITOR_HPP
 
+#include <algorithm>   // std::count
+#include <functional>  // std::function
+#include <iterator>    // std::next
 #include <list>
 #include <string>
+#include <string_view>
 #include <utility>  // std::pair
+#include <vector>
 
 #include "List.hpp"
 
+#ifdef EDITOR_COUNT_ALLOCATIONS
+#include "CountingAllocator.hpp"
+#endif
+
 class Editor {
+    // OVERVIEW: a text buffer with a cursor. The text is UTF-8: columns
+    //           count code points, and the cursor moves over a whole
+    //           character (a base code point with any combining marks or
+    //           zero-width-joined code points that follow it) at a time.
+    //           Bytes that are not valid UTF-8 are treated as one code
+    //           point each when they start a row, and are otherwise
+    //           joined to the code point before them.
+
     // using TextBuffer = List<char>;
     // using Iterator = List<char>::Iterator;
 
+#ifdef EDITOR_COUNT_ALLOCATIONS  // record the text's memory use (see allocation_counts())
+    using TextBuffer = std::list<char, CountingAllocator<char>>;
+#else
     using TextBuffer = std::list<char>;
-    using Iterator = std::list<char>::iterator;
+#endif
+    using Iterator = TextBuffer::iterator;
 
    public:
+    // A saved cursor position, which can be returned to in constant
+    // time. It is only valid until the text is next edited.
+    class Position {
+        friend class Editor;
+        Iterator cursor;
+        int row;
+        int column;
+        int index;
+    };
+
+    // Called on each edit with the row and column where it starts, and
+    // the number of newlines it removed and inserted.
+    using EditCallback =
+        std::function<void(int row, int column, int removed_rows, int inserted_rows)>;
+
+    // Called after each edit with the index where it starts, the number
+    // of bytes it removed, and the text it inserted.
+    using ChangeCallback =
+        std::function<void(int index, int removed_bytes, std::string_view inserted)>;
+
+    // The default distance, in bytes, between the checkpoints that
+    // seek() and seek_row_col() keep.
+    static constexpr int CHECKPOINT_INTERVAL = 256;
+
     // EFFECTS: Creates a new editor with an empty text buffer, with the
     //          current position at row 1 and column 0.
-    Editor() : buffer(), row(1), column(0), index(0) {
+    Editor() : Editor(CHECKPOINT_INTERVAL) {}
+
+    // REQUIRES: checkpoint_interval_in > 0
+    // EFFECTS: Creates a new editor as above, that keeps a checkpoint
+    //          for seeking every checkpoint_interval_in bytes.
+    explicit Editor(int checkpoint_interval_in)
+        : buffer(), row(1), column(0), index(0), checkpoint_interval(checkpoint_interval_in) {
+        assert(checkpoint_interval > 0);
         buffer.push_back(0);
         end_sentinel = buffer.begin();
         buffer.push_front(0);
@@ -37,16 +89,17 @@ class Editor {
         if (is_at_end()) {
             return false;
         }
+        count_step();
 
         assert(cursor != buffer.end());
         if (*cursor == '\n') {
             ++row;
             column = 0;
+            ++cursor;
+            ++index;
         } else {
-            ++column;
+            cursor = skip_character(cursor, column, index);
         }
-        ++cursor;
-        ++index;
         return true;
     }
 
@@ -62,16 +115,27 @@ class Editor {
         if (is_at_start()) {
             return false;
         }
+        count_step();
 
-        --cursor;
-        --index;
-        assert(cursor != buffer.end());
-        if (cursor != start_sentinel && *cursor == '\n') {
+        if (*std::prev(cursor) == '\n') {
+            --cursor;
+            --index;
             --row;
             column = compute_column();
-        } else {
-            --column;
+            return true;
         }
+        // step back over code points until reaching the start of the
+        // character they belong to
+        do {
+            --cursor;
+            --index;
+            while (is_continuation(*cursor) && !is_row_start(cursor)) {
+                --cursor;
+                --index;
+            }
+            --column;
+        } while (column > 0 && joins_previous(cursor));
+        assert(cursor != buffer.end());
         return true;
     }
 
@@ -79,15 +143,41 @@ class Editor {
     // EFFECTS:  Inserts a character in the buffer at the cursor and
     //           updates the current row and column.
     void insert(char c) {
+        notify_edit(row, column, 0, c == '\n' ? 1 : 0);
         cursor = buffer.insert(cursor, c);
         ++cursor;
         ++index;
         if (c == '\n') {  // <ENTER>
             ++row;
             column = 0;
-        } else {
+        } else if (is_ascii(c)) {
             ++column;
+        } else {  // may or may not start a code point
+            column = compute_column();
         }
+        edited(index - 1, 0, std::string_view(&c, 1), 0, c == '\n' ? 1 : 0);
+    }
+
+    // MODIFIES: *this
+    // EFFECTS:  Inserts all the characters of text in the buffer at the
+    //           cursor, as if by calling insert() on each of them in
+    //           order, and updates the current row and column.
+    void insert(const std::string &text) {
+        buffer.insert(cursor, text.begin(), text.end());
+        index += text.size();
+        std::size_t last_newline = text.rfind('\n');
+        std::size_t last_row_start = (last_newline == std::string::npos ? 0 : last_newline + 1);
+        int inserted_rows = std::count(text.begin(), text.end(), '\n');
+        notify_edit(row, column, 0, inserted_rows);
+        row += inserted_rows;
+        if (!std::all_of(text.begin() + last_row_start, text.end(), is_ascii)) {
+            column = compute_column();
+        } else if (last_newline == std::string::npos) {
+            column += text.size();
+        } else {
+            column = text.size() - last_row_start;
+        }
+        edited(index - static_cast<int>(text.size()), 0, text, 0, inserted_rows);
     }
 
     // MODIFIES: *this
@@ -102,13 +192,55 @@ class Editor {
             return false;
         }
 
+        Iterator old_cursor = cursor;
+        int old_index = index;
         if (!backward()) {
             return false;
         }
-        cursor = buffer.erase(cursor);
+        int removed_rows = (*cursor == '\n' ? 1 : 0);
+        notify_edit(row, column, removed_rows, 0);
+        cursor = buffer.erase(cursor, old_cursor);
+        edited(index, old_index - index, "", removed_rows, 0);
         return true;
     }
 
+    // REQUIRES: count bytes from the cursor, or the end of the buffer if
+    //           it is nearer, is the start of a character
+    // MODIFIES: *this
+    // EFFECTS:  Deletes up to count bytes from the buffer, starting at
+    //           the cursor and stopping at the end of the buffer. The
+    //           cursor then points at the character that followed the
+    //           last deleted one; its row, column, and index are
+    //           unchanged. Returns the deleted bytes.
+    std::string erase(int count) {
+        std::string text = copy(count);
+        int removed_rows = std::count(text.begin(), text.end(), '\n');
+        notify_edit(row, column, removed_rows, 0);
+        cursor = buffer.erase(cursor, std::next(cursor, text.size()));
+        edited(index, text.size(), "", removed_rows, 0);
+        return text;
+    }
+
+    // MODIFIES: *this
+    // EFFECTS:  Deletes the characters from the cursor to the end of the
+    //           current row, including the newline that ends the row if
+    //           there is one. Returns the deleted characters.
+    std::string erase_to_row_end() {
+        Iterator stop = cursor;
+        while (stop != end_sentinel && *stop != '\n') {
+            ++stop;
+        }
+        if (stop != end_sentinel) {
+            ++stop;  // include the newline
+        }
+        std::string text(cursor, stop);
+        int removed_rows = (stop != cursor && *std::prev(stop) == '\n' ? 1 : 0);
+        notify_edit(row, column, removed_rows, 0);
+        cursor = buffer.erase(cursor, stop);
+        edited(index, text.size(), "", removed_rows, 0);
+        return text;
+    }
+
     // MODIFIES: *this
     // EFFECTS:  Moves the cursor to the start of the current row (column
     //           0).
@@ -186,6 +318,85 @@ class Editor {
         return true;
     }
 
+    // REQUIRES: new_index >= 0
+    // MODIFIES: *this
+    // EFFECTS:  Moves the cursor to the character that contains the byte
+    //           at the given index, or to the end of the buffer if the
+    //           index is past it. Starts from the cursor or the nearest
+    //           checkpoint, adding checkpoints along the way, so that
+    //           seeking within text that has been seeked through before
+    //           walks at most about checkpoint_interval bytes.
+    void seek(int new_index) {
+        assert(new_index >= 0);
+        auto after = std::upper_bound(
+            checkpoints.begin(), checkpoints.end(), new_index,
+            [](int target, const Position &checkpoint) { return target < checkpoint.index; });
+        int start_index = (after == checkpoints.begin() ? 0 : std::prev(after)->index);
+        if (index > new_index && index - new_index < new_index - start_index) {
+            while (index > new_index) {  // the cursor is nearer
+                backward();
+            }
+            return;
+        }
+        move_to_checkpoint(after, index <= new_index);
+        walk_forward([&]() { return index >= new_index; });
+        if (index > new_index) {
+            backward();  // into the middle of a character
+        }
+    }
+
+    // REQUIRES: new_row >= 1, new_column >= 0
+    // MODIFIES: *this
+    // EFFECTS:  Moves the cursor to the given column in the given row, or
+    //           to the end of the row if it does not have that many
+    //           columns, or to the end of the buffer if there are not
+    //           that many rows. Starts from the cursor or the nearest
+    //           checkpoint, as seek() does.
+    void seek_row_col(int new_row, int new_column) {
+        assert(new_row >= 1 && new_column >= 0);
+        auto is_after = [](std::pair<int, int> target, const Position &checkpoint) {
+            return target < std::make_pair(checkpoint.row, checkpoint.column);
+        };
+        std::pair<int, int> target(new_row, new_column);
+        move_to_checkpoint(
+            std::upper_bound(checkpoints.begin(), checkpoints.end(), target, is_after),
+            !is_after(target, get_position()));
+        walk_forward([&]() {
+            return row > new_row ||
+                   (row == new_row && (column >= new_column || *cursor == '\n'));
+        });
+        if (row == new_row && column > new_column) {
+            backward();  // a character with combining marks spans columns
+        }
+    }
+
+    // REQUIRES: max_bytes > 0
+    // MODIFIES: *this
+    // EFFECTS:  Walks up to max_bytes from the first checkpoint that is
+    //           far from the next one (or from the end of the buffer),
+    //           adding checkpoints as seek() does, without moving the
+    //           cursor. Returns whether there was no such checkpoint
+    //           left, after which any seek walks at most about twice
+    //           checkpoint_interval bytes. Meant to be called in slices
+    //           while the editor is idle.
+    bool extend_checkpoints(int max_bytes) {
+        assert(max_bytes > 0);
+        auto gap = checkpoints.begin();
+        for (int gap_start = 0;
+             gap != checkpoints.end() && gap->index - gap_start <= 2 * checkpoint_interval;
+             ++gap) {
+            gap_start = gap->index;
+        }
+        bool last_gap = (gap == checkpoints.end());  // walking invalidates gap
+        Position saved = get_position();
+        move_to_checkpoint(gap, false);
+        int stop_index = index + max_bytes;
+        walk_forward([&]() { return index >= stop_index; });
+        bool reached_end = is_at_end();
+        set_position(saved);
+        return last_gap && reached_end;
+    }
+
     // EFFECTS:  Returns whether the cursor is at the end of the buffer.
     bool is_at_end() const {
         return cursor == end_sentinel;
@@ -193,11 +404,40 @@ class Editor {
 
     // REQUIRES: the cursor is not at the end of the buffer
     // EFFECTS:  Returns the character at the current cursor
+    // NOTE:     For a character that is not ASCII, this is only the first
+    //           byte of its encoding; see character_at_cursor().
     char data_at_cursor() const {
         assert(!is_at_end());
         return *cursor;
     }
 
+    // REQUIRES: the cursor is not at the end of the buffer
+    // EFFECTS:  Returns all the bytes of the character at the current
+    //           cursor, i.e. those that forward() moves over.
+    std::string character_at_cursor() const {
+        assert(!is_at_end());
+        if (*cursor == '\n') {
+            return "\n";
+        }
+        int code_points = 0;
+        int bytes = 0;
+        return std::string(cursor, skip_character(cursor, code_points, bytes));
+    }
+
+    // EFFECTS:  Returns the characters from the cursor up to, but not
+    //           including, the given column in the current row, or up to
+    //           the end of the row if it does not have that many
+    //           columns. Does not move the cursor.
+    std::string copy_to_column(int new_column) const {
+        Iterator stop = cursor;
+        int col = column;
+        int bytes = 0;
+        while (col < new_column && stop != end_sentinel && *stop != '\n') {
+            stop = skip_character(stop, col, bytes);
+        }
+        return std::string(cursor, stop);
+    }
+
     // EFFECTS:  Returns the row of the character at the current cursor.
     int get_row() const {
         return row;
@@ -224,6 +464,22 @@ class Editor {
         return buffer.size();
     }
 
+#ifdef EDITOR_COUNT_STEPS  // record how far the cursor walks (see step_count())
+    // EFFECTS:  Returns the number of times the cursor has moved by one
+    //           character, for profiling how far operations walk.
+    long step_count() const {
+        return steps;
+    }
+#endif
+
+#ifdef EDITOR_COUNT_ALLOCATIONS
+    // EFFECTS:  Returns the counts of the allocations made for the text
+    //           buffer, which are shared by every editor.
+    const AllocationCounts &allocation_counts() const {
+        return buffer.get_allocator().get_counts();
+    }
+#endif
+
     // EFFECTS:  Returns the contents of the text buffer as a string.
     std::string stringify() const {
         std::string result;
@@ -235,6 +491,82 @@ class Editor {
         return result;
     }
 
+    // REQUIRES: count bytes from the cursor, or the end of the buffer if
+    //           it is nearer, is the start of a character
+    // EFFECTS:  Returns up to count bytes starting at the cursor,
+    //           stopping at the end of the buffer. Does not move the
+    //           cursor.
+    std::string copy(int count) const {
+        std::string text;
+        auto it = cursor;
+        for (; count > 0 && it != end_sentinel; ++it, --count) {
+            text.push_back(*it);
+        }
+        assert(is_character_start(it));
+        return text;
+    }
+
+    // EFFECTS:  Returns the current position of the cursor.
+    Position get_position() const {
+        Position position;
+        position.cursor = cursor;
+        position.row = row;
+        position.column = column;
+        position.index = index;
+        return position;
+    }
+
+    // REQUIRES: position was returned by get_position() on this editor,
+    //           and the text has not been edited since
+    // MODIFIES: *this
+    // EFFECTS:  Moves the cursor back to the given position.
+    void set_position(const Position &position) {
+        cursor = position.cursor;
+        row = position.row;
+        column = position.column;
+        index = position.index;
+    }
+
+    // MODIFIES: *this
+    // EFFECTS:  Copies the text into nodes allocated one after another
+    //           in text order, and frees the old ones, so that walking
+    //           the text touches memory in order again after a long
+    //           session of edits has scattered its nodes across the
+    //           heap. The text, cursor, row, column, and index are
+    //           unchanged, and no callback is called, but positions
+    //           returned by get_position() are no longer valid.
+    void compact() {
+        TextBuffer compacted(buffer.begin(), buffer.end(), buffer.get_allocator());
+        auto checkpoint = checkpoints.begin();
+        int byte_index = -1;  // of the start sentinel
+        for (Iterator it = compacted.begin(); it != compacted.end(); ++it, ++byte_index) {
+            for (; checkpoint != checkpoints.end() && checkpoint->index == byte_index;
+                 ++checkpoint) {
+                checkpoint->cursor = it;
+            }
+            if (byte_index == index) {
+                cursor = it;
+            }
+        }
+        buffer.swap(compacted);
+        start_sentinel = buffer.begin();
+        end_sentinel = std::prev(buffer.end());
+    }
+
+    // MODIFIES: *this
+    // EFFECTS:  Sets the function to call on each edit, replacing
+    //           any previous one.
+    void set_edit_callback(EditCallback callback) {
+        edit_callback = callback;
+    }
+
+    // MODIFIES: *this
+    // EFFECTS:  Sets the function to call after each change to the
+    //           text, replacing any previous one.
+    void set_change_callback(ChangeCallback callback) {
+        change_callback = callback;
+    }
+
    private:
     TextBuffer buffer;        // linked list that contains the characters
     Iterator cursor;          // current position within the list
@@ -243,6 +575,13 @@ class Editor {
     int index;                // current index
     Iterator start_sentinel;  // sentinel node at the start of the list
     Iterator end_sentinel;    // sentinel node at the end of the list
+    EditCallback edit_callback;
+    ChangeCallback change_callback;
+    int checkpoint_interval;           // bytes between checkpoints
+    std::vector<Position> checkpoints;  // known positions, in order of index
+#ifdef EDITOR_COUNT_STEPS
+    long steps = 0;  // cursor moves by one character
+#endif
     // INVARIANT: cursor points at an actual character in the text, or to
     //            the end sentinel—i.e., cursor \in (start_sentinel, end_sentinel]
     // INVARIANT: row and column are the row and column numbers of the
@@ -251,6 +590,18 @@ class Editor {
     //            the cursor is pointing at with respect to the entire
     //            contents, or size() if the cursor is at the end of
     //            the buffer; 0 <= index <= size()
+    // INVARIANT: each checkpoint is at the start of a character, with
+    //            its correct row, column, and index; their indices are
+    //            strictly increasing
+
+    // MODIFIES: *this
+    // EFFECTS:  Counts a move of the cursor by one character, if steps
+    //           are counted.
+    void count_step() {
+#ifdef EDITOR_COUNT_STEPS
+        ++steps;
+#endif
+    }
 
     // EFFECTS: Computes the column of the cursor within the current
     //          row.
@@ -263,20 +614,240 @@ class Editor {
             return 0;
         }
 
-        while (cursor_aux != start_sentinel && *(--cursor_aux) != '\n') {
-            ++col;
+        while (!is_row_start(cursor_aux)) {
+            --cursor_aux;
+            col += (is_continuation(*cursor_aux) ? 0 : 1);
         }
-        if (cursor_aux == start_sentinel) {
-            return col - 1;  // start_sentinel is one-past-start
-        } else {
-            return col;
+        if (cursor_aux != cursor && is_continuation(*cursor_aux)) {
+            ++col;  // a row can start with a stray continuation byte
+        }
+        return col;
+    }
+
+    // REQUIRES: checkpoint is the first checkpoint after the target
+    //           position, and cursor_before is whether the cursor is
+    //           at or before it
+    // MODIFIES: *this
+    // EFFECTS:  Moves the cursor to the nearest known position at or
+    //           before the target: the cursor itself, the checkpoint
+    //           before the given one, or the start of the buffer.
+    void move_to_checkpoint(std::vector<Position>::iterator checkpoint, bool cursor_before) {
+        if (checkpoint != checkpoints.begin() &&
+            !(cursor_before && index >= std::prev(checkpoint)->index)) {
+            set_position(*std::prev(checkpoint));
+        } else if (!cursor_before) {
+            cursor = std::next(start_sentinel);
+            row = 1;
+            column = 0;
+            index = 0;
+        }
+    }
+
+    // MODIFIES: *this
+    // EFFECTS:  Moves the cursor forward until done() returns true or it
+    //           reaches the end of the buffer, adding a checkpoint
+    //           wherever it is checkpoint_interval bytes past the last.
+    template <typename Done>
+    void walk_forward(Done done) {
+        auto after = std::upper_bound(
+            checkpoints.begin(), checkpoints.end(), index,
+            [](int target, const Position &checkpoint) { return target < checkpoint.index; });
+        int next_checkpoint =
+            (after == checkpoints.begin() ? 0 : std::prev(after)->index) + checkpoint_interval;
+        while (!is_at_end() && !done()) {
+            forward();
+            for (; after != checkpoints.end() && after->index <= index; ++after) {
+                next_checkpoint = after->index + checkpoint_interval;
+            }
+            if (index >= next_checkpoint) {
+                after = checkpoints.insert(after, get_position()) + 1;
+                next_checkpoint = index + checkpoint_interval;
+            }
+        }
+    }
+
+    // REQUIRES: the cursor is just after an edit at edit_index, which
+    //           removed the given numbers of bytes and newlines and
+    //           inserted the given text, with the given number of
+    //           newlines
+    // MODIFIES: *this
+    // EFFECTS:  Updates the checkpoints and calls the change callback.
+    void edited(int edit_index, int removed_bytes, std::string_view inserted,
+                int removed_rows, int inserted_rows) {
+        update_checkpoints(edit_index, removed_bytes, inserted.size(), removed_rows,
+                           inserted_rows);
+        if (change_callback) {
+            change_callback(edit_index, removed_bytes, inserted);
+        }
+    }
+
+    // REQUIRES: the cursor is just after an edit at edit_index, which
+    //           removed the given numbers of bytes and newlines and
+    //           inserted the given numbers of them
+    // MODIFIES: *this
+    // EFFECTS:  Drops the checkpoints in removed text, and shifts those
+    //           after the edit. Those in the cursor's row shift columns
+    //           by the amount found by walking to the first of them,
+    //           which is dropped if it no longer starts a character.
+    void update_checkpoints(int edit_index, int removed_bytes, int inserted_bytes,
+                            int removed_rows, int inserted_rows) {
+        auto by_index = [](const Position &checkpoint, int target) {
+            return checkpoint.index < target;
+        };
+        auto first =
+            std::lower_bound(checkpoints.begin(), checkpoints.end(), edit_index, by_index);
+        if (first == checkpoints.end()) {
+            return;  // e.g. typing at the end of the text
+        }
+        first = checkpoints.erase(
+            first,
+            std::lower_bound(first, checkpoints.end(), edit_index + removed_bytes, by_index));
+        for (auto it = first; it != checkpoints.end(); ++it) {
+            it->index += inserted_bytes - removed_bytes;
+            it->row += inserted_rows - removed_rows;
+        }
+
+        Iterator it = cursor;
+        int col = column;
+        int bytes = index;
+        while (first != checkpoints.end() && first->row == row) {
+            while (bytes < first->index) {  // there is no newline before it in the row
+                it = skip_character(it, col, bytes);
+            }
+            if (bytes == first->index) {
+                break;
+            }
+            first = checkpoints.erase(first);
+        }
+        for (int shift = col - (first == checkpoints.end() ? 0 : first->column);
+             first != checkpoints.end() && first->row == row; ++first) {
+            first->column += shift;
         }
     }
 
     // helpers
+    void notify_edit(int edit_row, int edit_column, int removed_rows, int inserted_rows) const {
+        if (edit_callback) {
+            edit_callback(edit_row, edit_column, removed_rows, inserted_rows);
+        }
+    }
+
     bool is_at_start() const {
         return row == 1 && column == 0;
     }
+
+    // EFFECTS: Returns whether the given position is the first in its row.
+    bool is_row_start(Iterator it) const {
+        --it;
+        return it == start_sentinel || *it == '\n';
+    }
+
+    // EFFECTS: Returns whether a character starts at the given position,
+    //          or it is the end of the buffer.
+    bool is_character_start(Iterator it) const {
+        return it == end_sentinel || is_row_start(it) ||
+               (!is_continuation(*it) && !joins_previous(it));
+    }
+
+    // EFFECTS: Returns whether the code point starting at the given
+    //          position belongs to the same character as the one before
+    //          it.
+    bool joins_previous(Iterator it) const {
+        if (is_ascii(*it)) {
+            return false;
+        } else if (is_combining(decode(it))) {
+            return true;
+        }
+        const char joiner[] = "\xE2\x80\x8D";  // U+200D encoded in UTF-8
+        for (int i = 2; i >= 0; --i) {
+            if (--it == start_sentinel || *it != joiner[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+   public:
+    static constexpr char32_t ZERO_WIDTH_JOINER = 0x200D;
+    static constexpr char32_t INVALID_CODE_POINT = 0xFFFFFFFF;
+
+    // EFFECTS: Returns whether the given byte is ASCII.
+    static bool is_ascii(char c) {
+        return static_cast<unsigned char>(c) < 0x80;
+    }
+
+    // EFFECTS: Returns whether the given byte continues a UTF-8 encoded
+    //          code point rather than starting one.
+    static bool is_continuation(char c) {
+        return (static_cast<unsigned char>(c) & 0xC0) == 0x80;
+    }
+
+    // REQUIRES: the text at it ends with a null byte, as the buffer
+    //           does with its end sentinel and a C string does, and it
+    //           does not point at a newline
+    // EFFECTS:  Returns the position after the character at it, adding
+    //           the number of code points and bytes it spans to the
+    //           given counters.
+    template <typename Iter>
+    static Iter skip_character(Iter it, int &code_points, int &bytes) {
+        char32_t previous;
+        do {
+            previous = decode(it);
+            ++code_points;
+            ++bytes;
+            for (++it; is_continuation(*it); ++it) {  // stops at the null byte
+                ++bytes;
+            }
+        } while (!is_ascii(*it) && (previous == ZERO_WIDTH_JOINER || is_combining(decode(it))));
+        return it;
+    }
+
+    // REQUIRES: the text at it ends with a null byte
+    // EFFECTS:  Decodes the UTF-8 code point starting at the given
+    //           position, or returns INVALID_CODE_POINT if it is not
+    //           valid UTF-8.
+    template <typename Iter>
+    static char32_t decode(Iter it) {
+        unsigned char lead = *it;
+        if (lead < 0x80) {
+            return lead;
+        }
+        int length = (lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : 2);
+        if (lead < 0xC0 || lead >= 0xF8) {
+            return INVALID_CODE_POINT;
+        }
+        char32_t code_point = lead & (0x7F >> length);
+        for (int i = 1; i < length; ++i) {
+            if (!is_continuation(*++it)) {
+                return INVALID_CODE_POINT;
+            }
+            code_point = (code_point << 6) | (*it & 0x3F);
+        }
+        return code_point;
+    }
+
+    // EFFECTS: Returns whether the given code point is a combining mark
+    //          (or other zero-width extender) that belongs to the
+    //          character before it. This approximates the Unicode
+    //          Grapheme_Extend property for common scripts.
+    static bool is_combining(char32_t code_point) {
+        static const char32_t ranges[][2] = {
+            {0x0300, 0x036F},   {0x0483, 0x0489},   {0x0591, 0x05BD},   {0x05BF, 0x05BF},
+            {0x05C1, 0x05C2},   {0x05C4, 0x05C5},   {0x05C7, 0x05C7},   {0x0610, 0x061A},
+            {0x064B, 0x065F},   {0x0670, 0x0670},   {0x06D6, 0x06DC},   {0x06DF, 0x06E4},
+            {0x06E7, 0x06E8},   {0x06EA, 0x06ED},   {0x0E31, 0x0E31},   {0x0E34, 0x0E3A},
+            {0x0E47, 0x0E4E},   {0x1AB0, 0x1AFF},   {0x1DC0, 0x1DFF},   {0x200C, 0x200D},
+            {0x20D0, 0x20FF},   {0x302A, 0x302F},   {0x3099, 0x309A},   {0xFE00, 0xFE0F},
+            {0xFE20, 0xFE2F},   {0x1F3FB, 0x1F3FF}, {0xE0020, 0xE007F}, {0xE0100, 0xE01EF},
+        };
+        if (code_point < ranges[0][0]) {
+            return false;  // fast path
+        }
+        auto after = std::upper_bound(
+            std::begin(ranges), std::end(ranges), code_point,
+            [](char32_t target, const char32_t(&range)[2]) { return target < range[0]; });
+        return after != std::begin(ranges) && code_point <= (*(after - 1))[1];
+    }
 };
 
 #endif
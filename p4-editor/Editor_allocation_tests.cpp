@@ -0,0 +1,19 @@
+#include "Editor.hpp"
+
+#include <string>
+
+#define UNIT_TEST_COUNT_ALLOCATIONS 1
+#include "unit_test_framework.hpp"
+
+TEST(test_allocation_budget) {
+    Editor E;
+    E.insert(std::string("ab\ncd\nef"));
+    // one node per character, and nothing for moving around
+    ASSERT_ALLOCATIONS_AT_MOST(1, E.insert('g'));
+    ASSERT_ALLOCATIONS_AT_MOST(3, E.insert(std::string("hij")));
+    ASSERT_ALLOCATIONS_AT_MOST(0, E.up(); E.down(); E.backward(); E.forward());
+    ASSERT_ALLOCATIONS_AT_MOST(0, E.move_to_row_start(); E.move_to_row_end());
+    ASSERT_ALLOCATIONS_AT_MOST(0, E.remove());
+}
+
+TEST_MAIN()
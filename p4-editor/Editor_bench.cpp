@@ -0,0 +1,165 @@
+#include "Editor.hpp"
+
+#include <string>
+
+#include "unit_test_framework.hpp"
+
+using namespace std;
+
+const int ROWS = 1000;
+const int ROW_LENGTH = 80;  // including the newline
+
+// Helpers
+string make_text(int rows);
+void scatter(Editor &editor, int rows);
+
+BENCH(bench_load) {
+    string text = make_text(ROWS);
+    state.set_bytes_per_iteration(text.size());
+    while (state.keep_running()) {
+        Editor editor;
+        editor.insert(text);
+        DoNotOptimize(editor.get_index());
+    }
+}
+
+BENCH(bench_type_and_delete) {
+    Editor editor;
+    editor.insert(make_text(ROWS));
+    while (editor.get_row() > ROWS / 2) {
+        editor.up();
+    }
+    while (state.keep_running()) {
+        editor.insert('x');
+        editor.remove();
+        ClobberMemory();
+    }
+}
+
+BENCH(bench_cursor_walk) {
+    Editor editor;
+    editor.insert(make_text(ROWS));
+    state.set_items_per_iteration(2 * ROW_LENGTH);
+    while (state.keep_running()) {
+        for (int i = 0; i < ROW_LENGTH; ++i) {
+            editor.backward();
+        }
+        for (int i = 0; i < ROW_LENGTH; ++i) {
+            editor.forward();
+        }
+        DoNotOptimize(editor.get_index());
+    }
+}
+
+BENCH(bench_up_down) {
+    Editor editor;
+    editor.insert(make_text(ROWS));
+    editor.up();
+    editor.move_to_column(ROW_LENGTH / 2);
+    state.set_items_per_iteration(2);
+    while (state.keep_running()) {
+        editor.up();
+        editor.down();
+        DoNotOptimize(editor.get_index());
+    }
+}
+
+BENCH(bench_seek) {
+    Editor editor;
+    editor.insert(make_text(ROWS));
+    int size = editor.get_index();
+    int target = 0;
+    while (state.keep_running()) {
+        target = (target + 7919 * ROW_LENGTH + 17) % size;  // jump around the text
+        editor.seek(target);
+        DoNotOptimize(editor.get_row());
+    }
+}
+
+BENCH(bench_seek_row_col) {
+    Editor editor;
+    editor.insert(make_text(ROWS));
+    int target = 0;
+    while (state.keep_running()) {
+        target = (target + 7919) % ROWS;
+        editor.seek_row_col(target + 1, ROW_LENGTH / 2);
+        DoNotOptimize(editor.get_index());
+    }
+}
+
+BENCH(bench_stringify) {
+    Editor editor;
+    editor.insert(make_text(ROWS));
+    state.set_bytes_per_iteration(ROWS * ROW_LENGTH);
+    while (state.keep_running()) {
+        string text = editor.stringify();
+        DoNotOptimize(text.data());
+    }
+}
+
+BENCH(bench_scan_scattered) {
+    Editor editor;
+    scatter(editor, ROWS);
+    state.set_bytes_per_iteration(editor.get_index());
+    while (state.keep_running()) {
+        editor.seek(0);
+        while (editor.forward()) {
+        }
+        DoNotOptimize(editor.get_index());
+    }
+}
+
+BENCH(bench_scan_compacted) {
+    Editor editor;
+    scatter(editor, ROWS);
+    editor.compact();
+    state.set_bytes_per_iteration(editor.get_index());
+    while (state.keep_running()) {
+        editor.seek(0);
+        while (editor.forward()) {
+        }
+        DoNotOptimize(editor.get_index());
+    }
+}
+
+BENCH(bench_compact) {
+    Editor editor;
+    scatter(editor, ROWS);
+    state.set_bytes_per_iteration(editor.get_index());
+    while (state.keep_running()) {
+        editor.compact();
+        ClobberMemory();
+    }
+}
+
+string make_text(int rows) {
+    string row(ROW_LENGTH - 1, 'x');
+    row += '\n';
+    string text;
+    for (int i = 0; i < rows; ++i) {
+        text += row;
+    }
+    return text;
+}
+
+// Fills the editor with about the given number of rows the way a long
+// editing session does, typing and deleting all over the text, so that
+// its nodes are scattered across the heap rather than in text order.
+void scatter(Editor &editor, int rows) {
+    unsigned random = 1;
+    auto next_random = [&random](int bound) {
+        random = random * 1103515245 + 12345;
+        return int(random >> 8) % bound;
+    };
+    while (editor.get_index() < rows * ROW_LENGTH) {
+        editor.seek(next_random(editor.get_index() + 1));
+        if (next_random(4) == 0) {
+            editor.erase(4);
+        } else {
+            editor.insert(next_random(10) == 0 ? string("word\n") : string("word "));
+        }
+        editor.seek(rows * ROW_LENGTH);  // to the end, so that get_index() is the size
+    }
+}
+
+TEST_MAIN()
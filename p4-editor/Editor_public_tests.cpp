@@ -1,4 +1,7 @@
 #include "Editor.hpp"
+
+#include <vector>
+
 #include "unit_test_framework.hpp"
 
 TEST(test_new_editor) {
@@ -19,4 +22,224 @@ TEST(test_insert) {
     ASSERT_EQUAL(str, "A");
 }
 
+TEST(test_insert_string) {
+    Editor E;
+    E.insert(std::string("ab\ncd"));
+    ASSERT_EQUAL(E.get_row(), 2);
+    ASSERT_EQUAL(E.get_column(), 2);
+    ASSERT_EQUAL(E.get_index(), 5);
+    E.insert(std::string("e"));
+    ASSERT_EQUAL(E.get_column(), 3);
+    ASSERT_EQUAL(E.stringify(), "ab\ncde");
+}
+
+TEST(test_erase_copy) {
+    Editor E;
+    E.insert(std::string("ab\ncd\nef"));
+    E.up();
+    E.up();
+    E.move_to_column(1);
+    ASSERT_EQUAL(E.copy(4), "b\ncd");
+    ASSERT_EQUAL(E.erase(4), "b\ncd");
+    ASSERT_EQUAL(E.stringify(), "a\nef");
+    ASSERT_EQUAL(E.get_row(), 1);
+    ASSERT_EQUAL(E.get_column(), 1);
+    ASSERT_EQUAL(E.data_at_cursor(), '\n');
+    ASSERT_EQUAL(E.erase(100), "\nef");
+    ASSERT_TRUE(E.is_at_end());
+    ASSERT_EQUAL(E.stringify(), "a");
+}
+
+TEST(test_erase_to_row_end) {
+    Editor E;
+    E.insert(std::string("ab\ncd"));
+    E.up();
+    E.move_to_row_start();
+    ASSERT_EQUAL(E.erase_to_row_end(), "ab\n");
+    ASSERT_EQUAL(E.erase_to_row_end(), "cd");
+    ASSERT_EQUAL(E.erase_to_row_end(), "");
+    ASSERT_EQUAL(E.stringify(), "");
+}
+
+TEST(test_utf8_movement) {
+    Editor E;
+    // "a", "é" (2 bytes), "e" + combining acute (3 bytes), "中" (3 bytes)
+    E.insert(std::string("a\xC3\xA9\x65\xCC\x81\xE4\xB8\xAD"));
+    ASSERT_EQUAL(E.get_column(), 5);
+    ASSERT_EQUAL(E.get_index(), 9);
+    E.backward();
+    ASSERT_EQUAL(E.character_at_cursor(), "\xE4\xB8\xAD");
+    ASSERT_EQUAL(E.get_column(), 4);
+    E.backward();
+    ASSERT_EQUAL(E.character_at_cursor(), "\x65\xCC\x81");
+    ASSERT_EQUAL(E.get_column(), 2);
+    ASSERT_EQUAL(E.get_index(), 3);
+    E.move_to_row_start();
+    E.forward();
+    ASSERT_EQUAL(E.character_at_cursor(), "\xC3\xA9");
+    ASSERT_EQUAL(E.copy_to_column(4), "\xC3\xA9\x65\xCC\x81");
+    E.forward();
+    E.forward();
+    ASSERT_EQUAL(E.get_column(), 4);
+    ASSERT_EQUAL(E.get_index(), 6);
+}
+
+TEST(test_utf8_remove) {
+    Editor E;
+    E.insert(std::string("x\xC3\xA9\n\xE4\xB8\xAD"));
+    E.remove();
+    ASSERT_EQUAL(E.stringify(), "x\xC3\xA9\n");
+    E.remove();
+    ASSERT_EQUAL(E.get_column(), 2);
+    E.remove();
+    ASSERT_EQUAL(E.stringify(), "x");
+    ASSERT_EQUAL(E.get_column(), 1);
+    ASSERT_EQUAL(E.get_index(), 1);
+}
+
+TEST(test_edit_callback) {
+    Editor E;
+    std::vector<std::vector<int>> edits;
+    E.set_edit_callback([&edits](int row, int column, int removed_rows, int inserted_rows) {
+        edits.push_back({row, column, removed_rows, inserted_rows});
+    });
+    E.insert(std::string("ab\ncd"));
+    E.insert('\n');
+    E.remove();
+    E.move_to_row_start();
+    E.erase(2);
+    ASSERT_EQUAL(edits.size(), 4);
+    ASSERT_TRUE(edits[0] == std::vector<int>({1, 0, 0, 1}));
+    ASSERT_TRUE(edits[1] == std::vector<int>({2, 2, 0, 1}));
+    ASSERT_TRUE(edits[2] == std::vector<int>({2, 2, 1, 0}));
+    ASSERT_TRUE(edits[3] == std::vector<int>({2, 0, 0, 0}));
+}
+
+TEST(test_change_callback) {
+    Editor E;
+    std::string text;  // kept up to date from the changes alone
+    E.set_change_callback([&text](int index, int removed_bytes, std::string_view inserted) {
+        text.erase(index, removed_bytes);
+        text.insert(index, inserted);
+    });
+    E.insert(std::string("ab\ncd"));
+    E.insert('\xC3');
+    E.insert('\xA9');
+    E.remove();
+    E.move_to_row_start();
+    E.erase(1);
+    E.up();
+    E.erase_to_row_end();
+    ASSERT_EQUAL(text, E.stringify());
+    ASSERT_EQUAL(text, "d");
+}
+
+TEST(test_seek) {
+    Editor E(4);
+    E.insert(std::string("ab\ncd\xC3\xA9" "fgh\nij"));
+    E.seek(3);
+    ASSERT_EQUAL(E.get_row(), 2);
+    ASSERT_EQUAL(E.get_column(), 0);
+    E.seek(6);  // the second byte of "é"
+    ASSERT_EQUAL(E.get_index(), 5);
+    ASSERT_EQUAL(E.get_column(), 2);
+    E.seek(100);
+    ASSERT_TRUE(E.is_at_end());
+    E.seek(1);
+    ASSERT_EQUAL(E.data_at_cursor(), 'b');
+
+    // checkpoints stay correct as the text changes before them
+    E.seek(12);
+    E.seek(0);
+    E.insert(std::string("x\ny"));
+    E.seek(14);
+    ASSERT_EQUAL(E.get_row(), 4);
+    ASSERT_EQUAL(E.get_column(), 0);
+    ASSERT_EQUAL(E.data_at_cursor(), 'i');
+    E.seek(3);
+    E.erase(4);
+    E.seek(10);
+    ASSERT_EQUAL(E.get_row(), 3);
+    ASSERT_EQUAL(E.get_column(), 0);
+    ASSERT_EQUAL(E.data_at_cursor(), 'i');
+}
+
+TEST(test_seek_row_col) {
+    Editor E(4);
+    E.insert(std::string("abc\nd\xC3\xA9" "fg\n\nh"));
+    E.seek_row_col(2, 1);
+    ASSERT_EQUAL(E.get_index(), 5);
+    ASSERT_EQUAL(E.character_at_cursor(), "\xC3\xA9");
+    E.seek_row_col(1, 10);  // past the end of the row
+    ASSERT_EQUAL(E.get_index(), 3);
+    E.seek_row_col(3, 0);
+    ASSERT_EQUAL(E.data_at_cursor(), '\n');
+    E.seek_row_col(9, 0);  // past the last row
+    ASSERT_TRUE(E.is_at_end());
+    E.seek_row_col(2, 4);
+    E.move_to_row_start();
+    E.remove();  // join the first two rows
+    E.seek_row_col(1, 6);
+    ASSERT_EQUAL(E.get_index(), 7);
+    ASSERT_EQUAL(E.data_at_cursor(), 'g');
+}
+
+TEST(test_extend_checkpoints) {
+    Editor E(4);
+    E.insert(std::string("ab\ncd\xC3\xA9" "fgh\nij"));
+    E.seek(4);
+    ASSERT_FALSE(E.extend_checkpoints(3));
+    ASSERT_EQUAL(E.get_index(), 4);  // the cursor does not move
+    ASSERT_EQUAL(E.data_at_cursor(), 'd');
+    ASSERT_TRUE(E.extend_checkpoints(100));
+    ASSERT_TRUE(E.extend_checkpoints(1));
+    E.seek_row_col(3, 1);  // from the new checkpoints
+    ASSERT_EQUAL(E.data_at_cursor(), 'j');
+    E.seek(5);
+    ASSERT_EQUAL(E.get_column(), 2);
+    E.insert('X');  // checkpoints after an edit still place the cursor
+    E.seek(0);
+    ASSERT_TRUE(E.extend_checkpoints(100));
+    E.seek(12);
+    ASSERT_EQUAL(E.get_row(), 3);
+    ASSERT_EQUAL(E.data_at_cursor(), 'i');
+    E.seek(1);
+    E.insert(std::string(20, '-'));  // a long stretch without checkpoints
+    ASSERT_FALSE(E.extend_checkpoints(4));
+    ASSERT_EQUAL(E.get_index(), 21);
+    while (!E.extend_checkpoints(4)) {
+    }
+    E.seek_row_col(2, 1);
+    ASSERT_EQUAL(E.get_index(), 24);
+    ASSERT_EQUAL(E.data_at_cursor(), 'd');
+    Editor empty;
+    ASSERT_TRUE(empty.extend_checkpoints(1));
+    ASSERT_TRUE(empty.is_at_end());
+}
+
+TEST(test_compact) {
+    Editor E(4);
+    E.insert(std::string("one\ntwo\nthree\nfour"));
+    E.seek(9);  // checkpoints up to here
+    E.insert('X');
+    E.compact();
+    ASSERT_EQUAL(E.stringify(), "one\ntwo\ntXhree\nfour");
+    ASSERT_EQUAL(E.get_index(), 10);
+    ASSERT_EQUAL(E.get_row(), 3);
+    ASSERT_EQUAL(E.get_column(), 2);
+    ASSERT_EQUAL(E.data_at_cursor(), 'h');
+    E.remove();  // the cursor still works for edits
+    E.seek_row_col(2, 1);  // and the checkpoints for seeks
+    ASSERT_EQUAL(E.data_at_cursor(), 'w');
+    E.seek(100);
+    E.compact();  // with the cursor at the end
+    ASSERT_TRUE(E.is_at_end());
+    ASSERT_TRUE(E.backward());
+    ASSERT_EQUAL(E.data_at_cursor(), 'r');
+    Editor empty;
+    empty.compact();
+    ASSERT_TRUE(empty.is_at_end());
+    ASSERT_FALSE(empty.backward());
+}
+
 TEST_MAIN()
\ No newline at end of file
@@ -0,0 +1,152 @@
+#ifndef FILE_VIEW_HPP
+#define FILE_VIEW_HPP
+/* FileView.hpp
+ *
+ * read-only, memory-mapped view of a file, with a sparse line index
+ * that is built in the background
+ */
+
+#include <fcntl.h>     // open
+#include <sys/mman.h>  // mmap, madvise
+#include <sys/stat.h>  // fstat
+#include <unistd.h>    // close, sysconf
+
+#include <cstddef>  // std::size_t
+#include <cstring>  // std::memchr
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "LineIndex.hpp"
+
+class FileView {
+    // OVERVIEW: a file mapped read-only into memory, with a LineIndex
+    //           that is built by background threads. Pages are released
+    //           once they have been indexed, so that resident memory
+    //           does not grow with the file size.
+   public:
+    using Line = LineIndex::Line;
+
+    // EFFECTS: Maps the given file and starts indexing it. Throws
+    //          std::runtime_error if the file cannot be opened or
+    //          mapped.
+    explicit FileView(const std::string &filename,
+                      std::size_t interval = LineIndex::DEFAULT_INTERVAL)
+        : fd(-1), bytes(nullptr), length(0) {
+        fd = open(filename.c_str(), O_RDONLY);
+        struct stat info;
+        if (fd < 0 || fstat(fd, &info) != 0) {
+            close_file();
+            throw std::runtime_error("Unable to open " + filename);
+        }
+        length = info.st_size;
+        if (length > 0) {
+            void *mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping == MAP_FAILED) {
+                close_file();
+                throw std::runtime_error("Unable to map " + filename);
+            }
+            bytes = static_cast<const char *>(mapping);
+            madvise(mapping, length, MADV_SEQUENTIAL);
+        }
+        index = std::make_unique<LineIndex>(
+            bytes, length, interval, 0, LineIndex::DEFAULT_CHUNK_SIZE,
+            [this](std::size_t begin, std::size_t end) { release(begin, end); });
+    }
+
+    // disable copying
+    FileView(const FileView &) = delete;
+    FileView &operator=(const FileView &) = delete;
+
+    ~FileView() {
+        index.reset();  // stop indexing before unmapping
+        close_file();
+    }
+
+    // EFFECTS: Returns the contents of the file.
+    const char *data() const {
+        return bytes;
+    }
+
+    // EFFECTS: Returns the number of bytes in the file.
+    std::size_t size() const {
+        return length;
+    }
+
+    // EFFECTS: Returns whether the whole file has been indexed.
+    bool indexing_done() const {
+        return index->done();
+    }
+
+    // EFFECTS: Returns the number of lines indexed so far. This is the
+    //          number of lines in the file once indexing is done.
+    std::size_t line_count() const {
+        return index->line_count();
+    }
+
+    // EFFECTS: Returns the line with the given number, or the last line
+    //          if the file has fewer lines.
+    Line find_line(std::size_t number) const {
+        return index->find_line(number);
+    }
+
+    // REQUIRES: offset <= size()
+    // EFFECTS:  Returns the line containing the byte at the given offset.
+    Line line_containing(std::size_t offset) const {
+        return index->line_containing(offset);
+    }
+
+    // REQUIRES: offset <= size()
+    // EFFECTS:  Returns the offset of the newline that ends the line
+    //           containing the given offset, or size() if it is the last
+    //           line.
+    std::size_t line_end(std::size_t offset) const {
+        if (length == 0) {
+            return 0;  // an empty file is not mapped, so there is nothing to search
+        }
+        const void *newline = std::memchr(bytes + offset, '\n', length - offset);
+        return newline ? static_cast<const char *>(newline) - bytes : length;
+    }
+
+    // REQUIRES: offset is the start of a line other than the first
+    // EFFECTS:  Returns the offset of the start of the previous line.
+    std::size_t previous_line(std::size_t offset) const {
+        std::size_t start = offset - 1;  // skip the newline ending the previous line
+        while (start > 0 && bytes[start - 1] != '\n') {
+            --start;
+        }
+        return start;
+    }
+
+    // EFFECTS: Tells the operating system that the pages holding bytes
+    //          [begin, end) will not be needed soon. They are read back
+    //          from the file if they are accessed again.
+    void release(std::size_t begin, std::size_t end) const {
+        static const std::size_t page_size = sysconf(_SC_PAGESIZE);
+        begin -= begin % page_size;
+        if (bytes && begin < end) {
+            madvise(const_cast<char *>(bytes) + begin, end - begin, MADV_DONTNEED);
+        }
+    }
+
+   private:
+    int fd;
+    const char *bytes;
+    std::size_t length;
+    std::unique_ptr<LineIndex> index;
+
+    // MODIFIES: *this
+    // EFFECTS:  Unmaps and closes the file.
+    void close_file() {
+        if (bytes) {
+            munmap(const_cast<char *>(bytes), length);
+            bytes = nullptr;
+        }
+        if (fd >= 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+};
+
+#endif
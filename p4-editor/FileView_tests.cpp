@@ -0,0 +1,97 @@
+#include "FileView.hpp"
+
+#include <cstdio>  // std::remove
+#include <fstream>
+#include <thread>
+
+#include "unit_test_framework.hpp"
+
+using namespace std;
+
+// Helpers
+const char *const TEST_FILE = "FileView_tests.tmp";
+void write_test_file(const string &contents);
+void wait_for_index(const FileView &view);
+
+TEST(test_find_line) {
+    write_test_file("a\nbb\n\nccc\ndd");
+    FileView view(TEST_FILE, 2);
+    wait_for_index(view);
+    ASSERT_EQUAL(view.line_count(), 5);
+    ASSERT_EQUAL(view.find_line(1).offset, 0);
+    ASSERT_EQUAL(view.find_line(2).offset, 2);
+    ASSERT_EQUAL(view.find_line(3).offset, 5);
+    ASSERT_EQUAL(view.find_line(4).offset, 6);
+    ASSERT_EQUAL(view.find_line(5).offset, 10);
+
+    // past the last line
+    FileView::Line last = view.find_line(100);
+    ASSERT_EQUAL(last.number, 5);
+    ASSERT_EQUAL(last.offset, 10);
+    remove(TEST_FILE);
+}
+
+TEST(test_line_containing) {
+    write_test_file("a\nbb\n\nccc\n");
+    FileView view(TEST_FILE, 1);
+    wait_for_index(view);
+    ASSERT_EQUAL(view.line_count(), 5);
+    ASSERT_EQUAL(view.line_containing(0).number, 1);
+    ASSERT_EQUAL(view.line_containing(1).number, 1);  // newline ends row 1
+    ASSERT_EQUAL(view.line_containing(3).number, 2);
+    ASSERT_EQUAL(view.line_containing(3).offset, 2);
+    ASSERT_EQUAL(view.line_containing(8).number, 4);
+    ASSERT_EQUAL(view.line_containing(8).offset, 6);
+    ASSERT_EQUAL(view.line_containing(10).number, 5);
+    remove(TEST_FILE);
+}
+
+TEST(test_line_end_previous_line) {
+    write_test_file("a\nbb\n\nccc");
+    FileView view(TEST_FILE);
+    ASSERT_EQUAL(view.line_end(0), 1);
+    ASSERT_EQUAL(view.line_end(3), 4);
+    ASSERT_EQUAL(view.line_end(5), 5);
+    ASSERT_EQUAL(view.line_end(7), 9);
+    ASSERT_EQUAL(view.previous_line(2), 0);
+    ASSERT_EQUAL(view.previous_line(5), 2);
+    ASSERT_EQUAL(view.previous_line(6), 5);
+    remove(TEST_FILE);
+}
+
+TEST(test_empty_file) {
+    write_test_file("");
+    FileView view(TEST_FILE);
+    wait_for_index(view);
+    ASSERT_EQUAL(view.size(), 0);
+    ASSERT_EQUAL(view.line_count(), 1);
+    ASSERT_EQUAL(view.find_line(3).number, 1);
+    ASSERT_EQUAL(view.line_end(0), 0);
+    ASSERT_EQUAL(view.line_containing(0).number, 1);
+    ASSERT_TRUE(view.data() == nullptr);  // an empty file is not mapped
+    remove(TEST_FILE);
+}
+
+TEST(test_missing_file) {
+    bool thrown = false;
+    try {
+        FileView view("FileView_tests.missing");
+    } catch (const runtime_error &) {
+        thrown = true;
+    }
+    ASSERT_TRUE(thrown);
+}
+
+TEST_MAIN()
+
+// Helpers implementation
+void write_test_file(const string &contents) {
+    ofstream output(TEST_FILE, ios::binary);
+    output << contents;
+}
+
+void wait_for_index(const FileView &view) {
+    while (!view.indexing_done()) {
+        this_thread::yield();
+    }
+}
@@ -0,0 +1,131 @@
+#ifndef FUZZ_HPP
+#define FUZZ_HPP
+/* Fuzz.hpp
+ *
+ * deterministic random-operation fuzzing, which runs sequences of
+ * operations against an implementation and a model of it and shrinks
+ * any sequence that makes them disagree
+ */
+
+#include <algorithm>  // std::min
+#include <cstddef>    // std::size_t
+#include <cstdint>    // std::uint64_t
+#include <functional>
+#include <string>
+#include <vector>
+
+class FuzzRandom {
+    // OVERVIEW: a small, fast pseudorandom generator (SplitMix64). Its
+    //           sequence depends only on its seed, on every platform,
+    //           unlike those of the distributions in <random>.
+   public:
+    explicit FuzzRandom(std::uint64_t seed_in) : state(seed_in) {}
+
+    // MODIFIES: *this
+    // EFFECTS:  Returns the next number in the sequence.
+    std::uint64_t next() {
+        std::uint64_t z = (state += 0x9e3779b97f4a7c15);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+        return z ^ (z >> 31);
+    }
+
+    // REQUIRES: n > 0
+    // MODIFIES: *this
+    // EFFECTS:  Returns a number in [0, n).
+    int below(int n) {
+        return next() % n;
+    }
+
+   private:
+    std::uint64_t state;
+};
+
+// Where and how an implementation first disagreed with its model.
+struct FuzzFailure {
+    bool failed = false;
+    std::size_t op_index = 0;  // the operation after which they disagreed
+    std::string message;
+};
+
+// Runs a sequence of operations from a fresh state, checking the
+// implementation against the model after each one.
+template <typename Op>
+using FuzzRun = std::function<FuzzFailure(const std::vector<Op> &ops)>;
+
+// Makes a random operation.
+template <typename Op>
+using FuzzGenerate = std::function<Op(FuzzRandom &random)>;
+
+// The outcome of a fuzzing campaign.
+template <typename Op>
+struct FuzzReport {
+    std::size_t ops_run = 0;
+    bool failed = false;
+    std::uint64_t seed = 0;  // of the failing sequence
+    std::vector<Op> ops;     // shrunk failing sequence
+    FuzzFailure failure;     // of the shrunk sequence
+};
+
+// REQUIRES: run(ops) fails
+// EFFECTS:  Returns a subsequence of ops that still fails, and from
+//           which no single operation can be removed without it
+//           passing. Chunks of operations are removed while the
+//           sequence still fails, halving the chunk size down to one,
+//           and the sequence is cut after its failing operation.
+template <typename Op>
+std::vector<Op> shrink(std::vector<Op> ops, const FuzzRun<Op> &run) {
+    ops.resize(run(ops).op_index + 1);
+    std::size_t chunk = std::max<std::size_t>(ops.size() / 2, 1);
+    while (true) {
+        bool removed = false;
+        for (std::size_t start = 0; start < ops.size();) {
+            std::vector<Op> candidate(ops.begin(), ops.begin() + start);
+            candidate.insert(candidate.end(), ops.begin() + std::min(start + chunk, ops.size()),
+                             ops.end());
+            FuzzFailure failure = run(candidate);
+            if (failure.failed) {
+                candidate.resize(failure.op_index + 1);
+                ops.swap(candidate);
+                removed = true;
+            } else {
+                start += chunk;
+            }
+        }
+        if (chunk > 1) {
+            chunk /= 2;
+        } else if (!removed) {
+            break;  // no single operation can be removed
+        }
+    }
+    return ops;
+}
+
+// EFFECTS: Runs sequences of length ops each, made by generate from the
+//          seeds seed, seed + 1, ..., until count operations have been
+//          run or a sequence fails. Returns a report with the first
+//          failing sequence shrunk, if there is one.
+template <typename Op>
+FuzzReport<Op> fuzz(std::uint64_t seed, std::size_t count, std::size_t length,
+                    const FuzzGenerate<Op> &generate, const FuzzRun<Op> &run) {
+    FuzzReport<Op> report;
+    std::vector<Op> ops;
+    for (; report.ops_run < count; ++seed) {
+        FuzzRandom random(seed);
+        ops.clear();
+        for (std::size_t i = 0; i < length && report.ops_run + i < count; ++i) {
+            ops.push_back(generate(random));
+        }
+        report.ops_run += ops.size();
+        if (run(ops).failed) {
+            report.failed = true;
+            report.seed = seed;
+            report.ops = shrink(ops, run);
+            report.failure = run(report.ops);
+            break;
+        }
+    }
+    return report;
+}
+
+#endif
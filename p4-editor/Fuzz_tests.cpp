@@ -0,0 +1,73 @@
+#include "Fuzz.hpp"
+
+#include "unit_test_framework.hpp"
+
+using namespace std;
+
+// Helpers
+FuzzFailure fail_on_second_seven(const vector<int> &ops);
+
+TEST(test_random_deterministic) {
+    FuzzRandom a(42);
+    FuzzRandom b(42);
+    FuzzRandom c(43);
+    bool differs = false;
+    for (int i = 0; i < 100; ++i) {
+        uint64_t value = a.next();
+        ASSERT_EQUAL(value, b.next());
+        differs = differs || value != c.next();
+    }
+    ASSERT_TRUE(differs);
+}
+
+TEST(test_random_below) {
+    FuzzRandom random(1);
+    vector<int> seen(5);
+    for (int i = 0; i < 1000; ++i) {
+        int value = random.below(5);
+        ASSERT_TRUE(value >= 0 && value < 5);
+        ++seen[value];
+    }
+    for (int count : seen) {
+        ASSERT_TRUE(count > 100);
+    }
+}
+
+TEST(test_shrink_to_minimal) {
+    vector<int> ops = {1, 7, 3, 4, 5, 7, 2, 7, 9};
+    vector<int> shrunk = shrink<int>(ops, fail_on_second_seven);
+    ASSERT_SEQUENCE_EQUAL(shrunk, vector<int>({7, 7}));
+    ASSERT_EQUAL(fail_on_second_seven(shrunk).op_index, 1u);
+}
+
+TEST(test_fuzz_passes) {
+    FuzzReport<int> report = fuzz<int>(
+        1, 1050, 100, [](FuzzRandom &random) { return random.below(10); },
+        [](const vector<int> &) { return FuzzFailure(); });
+    ASSERT_FALSE(report.failed);
+    ASSERT_EQUAL(report.ops_run, 1050u);
+}
+
+TEST(test_fuzz_finds_and_shrinks) {
+    FuzzReport<int> report =
+        fuzz<int>(5, 100000, 50, [](FuzzRandom &random) { return random.below(10); },
+                  fail_on_second_seven);
+    ASSERT_TRUE(report.failed);
+    ASSERT_TRUE(report.ops_run <= 50 * (report.seed - 4));
+    ASSERT_SEQUENCE_EQUAL(report.ops, vector<int>({7, 7}));
+    ASSERT_TRUE(report.failure.failed);
+    ASSERT_EQUAL(report.failure.message, "second 7");
+}
+
+// Fails just after the second 7 in the operations.
+FuzzFailure fail_on_second_seven(const vector<int> &ops) {
+    int sevens = 0;
+    for (size_t i = 0; i < ops.size(); ++i) {
+        if (ops[i] == 7 && ++sevens == 2) {
+            return {true, i, "second 7"};
+        }
+    }
+    return FuzzFailure();
+}
+
+TEST_MAIN()
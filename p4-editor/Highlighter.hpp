@@ -0,0 +1,224 @@
+#ifndef HIGHLIGHTER_HPP
+#define HIGHLIGHTER_HPP
+/* Highlighter.hpp
+ *
+ * incremental syntax highlighting for C and C++ source, with the lexer
+ * state at the start of each line cached between edits
+ */
+
+#include <algorithm>  // std::binary_search, std::min
+#include <cstddef>    // std::size_t
+#include <iterator>   // std::begin, std::end
+#include <string>
+#include <string_view>
+#include <vector>
+
+class Highlighter {
+    // OVERVIEW: colors the rows of a C or C++ source text. The lexer
+    //           state at the start of each row (inside a block comment
+    //           or not) is cached. An edit invalidates the states after
+    //           the row it starts in, and rows are re-lexed from there
+    //           only until the state at the start of a row past the
+    //           edit matches the cached one. From that row on, the
+    //           cached states are still correct, so an edit costs time
+    //           proportional to the rows it changes rather than to the
+    //           size of the text.
+   public:
+    enum Color { PLAIN, KEYWORD, COMMENT, STRING, NUMBER, PREPROCESSOR, NUM_COLORS };
+
+    // Lexer state at the start of a row.
+    enum State : unsigned char { NORMAL, IN_COMMENT };
+
+    // Bytes [begin, end) of a row drawn in the given color.
+    struct Span {
+        std::size_t begin;
+        std::size_t end;
+        Color color;
+    };
+
+    // EFFECTS: Creates a highlighter for a text whose first row starts
+    //          in the normal state.
+    Highlighter() : starts(1, NORMAL), valid(1), stale_through(0) {}
+
+    // EFFECTS: Returns whether a file with the given name is C or C++
+    //          source that can be highlighted.
+    static bool supports(const std::string &filename) {
+        static const char *const extensions[] = {".c", ".cc", ".cpp", ".cxx",
+                                                 ".h", ".hh", ".hpp", ".hxx"};
+        std::size_t dot = filename.rfind('.');
+        if (dot == std::string::npos) {
+            return false;
+        }
+        std::string extension = filename.substr(dot);
+        for (const char *supported : extensions) {
+            if (extension == supported) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // EFFECTS: Lexes a row (without its newline) that starts in the
+    //          given state, appending the spans that are not PLAIN to
+    //          spans if it is not null. Returns the state at the end of
+    //          the row.
+    static State lex_row(State state, const std::string &text, std::vector<Span> *spans) {
+        std::size_t size = text.size();
+        std::size_t i = 0;
+        auto add = [spans](std::size_t begin, std::size_t end, Color color) {
+            if (spans && begin < end) {
+                spans->push_back({begin, end, color});
+            }
+        };
+        if (state == IN_COMMENT) {
+            std::size_t close = text.find("*/");
+            if (close == std::string::npos) {
+                add(0, size, COMMENT);
+                return IN_COMMENT;
+            }
+            i = close + 2;
+            add(0, i, COMMENT);
+        }
+        std::size_t first = text.find_first_not_of(" \t");
+        if (first != std::string::npos && first >= i && text[first] == '#') {
+            // color the directive name
+            std::size_t end = first + 1;
+            while (end < size && is_identifier(text[end])) {
+                ++end;
+            }
+            add(first, end, PREPROCESSOR);
+            i = end;
+        }
+        while (i < size) {
+            char c = text[i];
+            char next = (i + 1 < size ? text[i + 1] : '\0');
+            std::size_t end = i + 1;
+            if (c == '/' && next == '/') {
+                add(i, size, COMMENT);
+                return NORMAL;
+            } else if (c == '/' && next == '*') {
+                std::size_t close = text.find("*/", i + 2);
+                if (close == std::string::npos) {
+                    add(i, size, COMMENT);
+                    return IN_COMMENT;
+                }
+                end = close + 2;
+                add(i, end, COMMENT);
+            } else if (c == '"' || c == '\'') {
+                while (end < size && text[end] != c) {
+                    end += (text[end] == '\\' ? 2 : 1);  // skip escaped characters
+                }
+                end = std::min(end + 1, size);
+                add(i, end, STRING);
+            } else if (c >= '0' && c <= '9') {
+                while (end < size && (is_identifier(text[end]) || text[end] == '.' ||
+                                      text[end] == '\'')) {
+                    ++end;
+                }
+                add(i, end, NUMBER);
+            } else if (is_identifier(c)) {
+                while (end < size && is_identifier(text[end])) {
+                    ++end;
+                }
+                if (is_keyword(std::string_view(text).substr(i, end - i))) {
+                    add(i, end, KEYWORD);
+                }
+            }
+            i = end;
+        }
+        return NORMAL;
+    }
+
+    // MODIFIES: *this
+    // EFFECTS:  Records an edit that starts in the given row and removes
+    //           and inserts the given numbers of newlines.
+    void edit(int row, int removed_rows, int inserted_rows) {
+        // the state at the start of the edited row does not change, but
+        // those of the rows after it are unknown until they are re-lexed
+        std::size_t first = row;  // index of the row after the edited one
+        if (first < starts.size()) {
+            auto begin = starts.begin() + first;
+            starts.erase(begin, begin + std::min<std::size_t>(removed_rows, starts.size() - first));
+            starts.insert(starts.begin() + first, inserted_rows, NORMAL);
+        }
+        if (stale_through > row + removed_rows) {
+            stale_through += inserted_rows - removed_rows;
+        } else {
+            stale_through = std::max(stale_through, row + inserted_rows);
+        }
+        valid = std::min(valid, row);
+    }
+
+    // EFFECTS: Returns the number of leading rows whose start states are
+    //          known. This is at least 1.
+    int valid_rows() const {
+        return valid;
+    }
+
+    // REQUIRES: text is the contents of row valid_rows()
+    // MODIFIES: *this
+    // EFFECTS:  Lexes that row to find the state at the start of the
+    //           next one. If that matches the cached state and no edit
+    //           follows, the remaining cached states are known too.
+    void advance(const std::string &text) {
+        State end_state = lex_row(starts[valid - 1], text, nullptr);
+        if (valid < static_cast<int>(starts.size()) && valid >= stale_through &&
+            starts[valid] == end_state) {
+            valid = starts.size();  // converged
+            stale_through = 0;
+            return;
+        }
+        if (valid == static_cast<int>(starts.size())) {
+            starts.push_back(end_state);
+        } else {
+            starts[valid] = end_state;
+        }
+        ++valid;
+    }
+
+    // REQUIRES: row <= valid_rows() and text is the contents of that row
+    // EFFECTS:  Returns the colored spans of the row.
+    std::vector<Span> spans(int row, const std::string &text) const {
+        std::vector<Span> result;
+        lex_row(starts[row - 1], text, &result);
+        return result;
+    }
+
+   private:
+    std::vector<State> starts;  // state at the start of each row, from row 1
+    int valid;                  // number of leading rows with known start states
+    int stale_through;          // last row whose cached start state is unknown
+    // INVARIANT: 1 <= valid <= starts.size()
+    // INVARIANT: starts[0, valid) are the correct start states of rows
+    //            [1, valid]; entries after that hold the start states of
+    //            the same rows before the edits since, except for rows
+    //            up to stale_through, which were inserted or edited
+
+    // EFFECTS: Returns whether the byte can be part of an identifier.
+    //          Bytes of UTF-8 encoded characters are treated as letters.
+    static bool is_identifier(char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+               c == '_' || static_cast<unsigned char>(c) >= 0x80;
+    }
+
+    // EFFECTS: Returns whether the word is a C++ keyword.
+    static bool is_keyword(std::string_view word) {
+        // sorted for binary search
+        static constexpr std::string_view keywords[] = {
+            "alignas", "alignof", "and", "asm", "auto", "bool", "break", "case", "catch", "char",
+            "char16_t", "char32_t", "char8_t", "class", "co_await", "co_return", "co_yield",
+            "concept", "const", "const_cast", "consteval", "constexpr", "constinit", "continue",
+            "decltype", "default", "delete", "do", "double", "dynamic_cast", "else", "enum",
+            "explicit", "export", "extern", "false", "float", "for", "friend", "goto", "if",
+            "inline", "int", "long", "mutable", "namespace", "new", "noexcept", "not", "nullptr",
+            "operator", "or", "private", "protected", "public", "register", "reinterpret_cast",
+            "requires", "return", "short", "signed", "sizeof", "static", "static_assert",
+            "static_cast", "struct", "switch", "template", "this", "thread_local", "throw", "true",
+            "try", "typedef", "typeid", "typename", "union", "unsigned", "using", "virtual", "void",
+            "volatile", "wchar_t", "while",
+        };
+        return std::binary_search(std::begin(keywords), std::end(keywords), word);
+    }
+};
+
+#endif
@@ -0,0 +1,102 @@
+#include "Highlighter.hpp"
+
+#include <string>
+#include <vector>
+
+#include "unit_test_framework.hpp"
+
+using namespace std;
+
+// Helpers
+void advance_all(Highlighter &highlighter, const vector<string> &rows);
+
+TEST(test_supports) {
+    ASSERT_TRUE(Highlighter::supports("femto.cpp"));
+    ASSERT_TRUE(Highlighter::supports("dir.d/Editor.hpp"));
+    ASSERT_FALSE(Highlighter::supports("notes.txt"));
+    ASSERT_FALSE(Highlighter::supports("Makefile"));
+}
+
+TEST(test_lex_row) {
+    vector<Highlighter::Span> spans;
+    string text = "int x = 42; // \"answer\"";
+    ASSERT_EQUAL(Highlighter::lex_row(Highlighter::NORMAL, text, &spans), Highlighter::NORMAL);
+    ASSERT_EQUAL(spans.size(), 3);
+    ASSERT_EQUAL(spans[0].color, Highlighter::KEYWORD);
+    ASSERT_EQUAL(text.substr(spans[0].begin, spans[0].end - spans[0].begin), "int");
+    ASSERT_EQUAL(spans[1].color, Highlighter::NUMBER);
+    ASSERT_EQUAL(text.substr(spans[1].begin, spans[1].end - spans[1].begin), "42");
+    ASSERT_EQUAL(spans[2].color, Highlighter::COMMENT);
+    ASSERT_EQUAL(spans[2].end, text.size());
+}
+
+TEST(test_lex_strings_and_directives) {
+    vector<Highlighter::Span> spans;
+    string text = "#include \"a\\\"b\" // x";
+    Highlighter::lex_row(Highlighter::NORMAL, text, &spans);
+    ASSERT_EQUAL(spans.size(), 3);
+    ASSERT_EQUAL(spans[0].color, Highlighter::PREPROCESSOR);
+    ASSERT_EQUAL(spans[0].end, 8);
+    ASSERT_EQUAL(spans[1].color, Highlighter::STRING);
+    ASSERT_EQUAL(text.substr(spans[1].begin, spans[1].end - spans[1].begin), "\"a\\\"b\"");
+}
+
+TEST(test_block_comment_state) {
+    ASSERT_EQUAL(Highlighter::lex_row(Highlighter::NORMAL, "x /* y", nullptr),
+                 Highlighter::IN_COMMENT);
+    ASSERT_EQUAL(Highlighter::lex_row(Highlighter::IN_COMMENT, "still", nullptr),
+                 Highlighter::IN_COMMENT);
+    ASSERT_EQUAL(Highlighter::lex_row(Highlighter::IN_COMMENT, "*/ int", nullptr),
+                 Highlighter::NORMAL);
+    ASSERT_EQUAL(Highlighter::lex_row(Highlighter::NORMAL, "// /*", nullptr),
+                 Highlighter::NORMAL);
+}
+
+TEST(test_edit_converges) {
+    vector<string> rows = {"int a;", "/* b", "c */", "int d;", "int e;", "int f;"};
+    Highlighter highlighter;
+    advance_all(highlighter, rows);
+    ASSERT_EQUAL(highlighter.valid_rows(), 7);
+
+    // an edit that does not change any state is re-lexed in one step
+    rows[0] = "int aa;";
+    highlighter.edit(1, 0, 0);
+    ASSERT_EQUAL(highlighter.valid_rows(), 1);
+    highlighter.advance(rows[0]);
+    ASSERT_EQUAL(highlighter.valid_rows(), 7);
+
+    // opening a comment changes the states until it is closed
+    rows[3] = "int d; /*";
+    highlighter.edit(4, 0, 0);
+    highlighter.advance(rows[3]);
+    ASSERT_EQUAL(highlighter.valid_rows(), 5);
+    ASSERT_EQUAL(highlighter.spans(5, rows[4])[0].color, Highlighter::COMMENT);
+}
+
+TEST(test_edit_inserts_rows) {
+    vector<string> rows = {"int a;", "int b;", "/* c */", "int d;"};
+    Highlighter highlighter;
+    advance_all(highlighter, rows);
+
+    // split row 2 into "int" and " b;" then add a row that opens a comment
+    rows = {"int a;", "int", "/*", " b;", "/* c */", "int d;"};
+    highlighter.edit(2, 0, 1);
+    highlighter.edit(3, 0, 1);
+    advance_all(highlighter, rows);
+    ASSERT_EQUAL(highlighter.spans(4, rows[3])[0].color, Highlighter::COMMENT);
+    ASSERT_EQUAL(highlighter.spans(6, rows[5])[0].color, Highlighter::KEYWORD);
+
+    // remove the row with the comment opener
+    rows.erase(rows.begin() + 2);
+    highlighter.edit(3, 1, 0);
+    advance_all(highlighter, rows);
+    ASSERT_EQUAL(highlighter.spans(3, rows[2]).size(), 0);
+}
+
+void advance_all(Highlighter &highlighter, const vector<string> &rows) {
+    while (highlighter.valid_rows() <= static_cast<int>(rows.size())) {
+        highlighter.advance(rows[highlighter.valid_rows() - 1]);
+    }
+}
+
+TEST_MAIN()
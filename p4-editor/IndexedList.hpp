@@ -0,0 +1,519 @@
+#ifndef INDEXED_LIST_HPP
+#define INDEXED_LIST_HPP
+/* IndexedList.hpp
+ *
+ * list with the interface of List that also reaches the k-th element,
+ * and finds the index of an element, in logarithmic time
+ */
+
+#include <cassert>  // assert
+#include <cstddef>  // std::size_t, std::ptrdiff_t
+#include <cstdint>  // std::uint32_t
+#include <iterator>  // std::bidirectional_iterator_tag, std::reverse_iterator
+#include <memory>  // std::allocator, std::allocator_traits
+#include <type_traits>  // std::enable_if_t, std::remove_const_t
+#include <utility>  // std::swap
+
+template <typename T, typename Alloc = std::allocator<T>>
+class IndexedList {
+    // OVERVIEW: a sequence with the interface and bidirectional iterators
+    //           of List, kept as an implicit treap: a binary tree whose
+    //           in-order walk is the sequence, in which each node counts
+    //           the nodes below it and has a random priority that is
+    //           never more than its parent's. The tree is then balanced
+    //           with high probability, so reaching the k-th element,
+    //           finding the index of an element, and inserting or erasing
+    //           anywhere take expected O(log n) time. Stepping an
+    //           iterator takes O(1) amortized time. Inserting and
+    //           erasing invalidate only iterators to the erased element.
+   public:
+    explicit IndexedList(const Alloc &alloc = Alloc())
+        : root(nullptr), node_alloc(alloc), seed(0x9E3779B9u) {
+    }
+
+    IndexedList(const IndexedList &other)  // copy-ctor
+        : IndexedList(NodeTraits::select_on_container_copy_construction(other.node_alloc)) {
+        root = copy_tree(other.root, nullptr);
+    }
+
+    IndexedList &operator=(const IndexedList &other) {  // overloaded assignment
+        IndexedList temp{Alloc(node_alloc)};  // nodes must come from this list's allocator
+        temp.root = temp.copy_tree(other.root, nullptr);
+        std::swap(root, temp.root);
+        return *this;
+    }
+
+    ~IndexedList() {
+        clear();
+    }
+
+    // EFFECTS: returns a copy of the allocator used for the nodes
+    Alloc get_allocator() const {
+        return Alloc(node_alloc);
+    }
+
+    // EFFECTS:  returns true if the list is empty
+    bool empty() const {
+        return !root;
+    }
+
+    // EFFECTS: returns the number of elements in this list
+    int size() const {
+        return size_of(root);
+    }
+
+    // REQUIRES: list is not empty
+    // EFFECTS: Returns the first element in the list by reference
+    T &front() {
+        assert(!empty());
+        return leftmost(root)->datum;
+    }
+
+    const T &front() const {
+        assert(!empty());
+        return leftmost(root)->datum;
+    }
+
+    // REQUIRES: list is not empty
+    // EFFECTS: Returns the last element in the list by reference
+    T &back() {
+        assert(!empty());
+        return rightmost(root)->datum;
+    }
+
+    const T &back() const {
+        assert(!empty());
+        return rightmost(root)->datum;
+    }
+
+    // EFFECTS:  inserts datum into the front of the list
+    void push_front(const T &datum) {
+        insert(begin(), datum);
+    }
+
+    // EFFECTS:  inserts datum into the back of the list
+    void push_back(const T &datum) {
+        insert(end(), datum);
+    }
+
+    // REQUIRES: list is not empty
+    // MODIFIES: invalidates iterators to the first element
+    // EFFECTS:  removes the item at the front of the list
+    void pop_front() {
+        assert(!empty());
+        erase(begin());
+    }
+
+    // REQUIRES: list is not empty
+    // MODIFIES: invalidates iterators to the last element
+    // EFFECTS:  removes the item at the back of the list
+    void pop_back() {
+        assert(!empty());
+        erase(--end());
+    }
+
+    // MODIFIES: may invalidate list iterators
+    // EFFECTS:  removes all items from the list
+    void clear() {
+        destroy_tree(root);
+        root = nullptr;
+    }
+
+   private:
+    // a private type
+    struct Node {
+        Node *left;
+        Node *right;
+        Node *parent;         // or nullptr at the root
+        std::size_t size;     // nodes in the subtree rooted here
+        std::uint32_t priority;
+        T datum;
+    };
+
+    using NodeAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<Node>;
+    using NodeTraits = std::allocator_traits<NodeAlloc>;
+
+    Node *root;  // or nullptr if the list is empty
+
+    NodeAlloc node_alloc;  // allocates every Node in the list
+
+    std::uint32_t seed;  // state of the xorshift generator for priorities
+
+    static std::size_t size_of(const Node *node) {
+        return node ? node->size : 0;
+    }
+
+    static Node *leftmost(Node *node) {
+        while (node->left) {
+            node = node->left;
+        }
+        return node;
+    }
+
+    static Node *rightmost(Node *node) {
+        while (node->right) {
+            node = node->right;
+        }
+        return node;
+    }
+
+    // EFFECTS: returns the next priority from the xorshift generator
+    std::uint32_t next_priority() {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        return seed;
+    }
+
+    // EFFECTS: makes replacement take the place of child under parent, or
+    //          at the root if parent is nullptr
+    void replace_child(Node *parent, Node *child, Node *replacement) {
+        if (!parent) {
+            root = replacement;
+        } else if (parent->left == child) {
+            parent->left = replacement;
+        } else {
+            parent->right = replacement;
+        }
+        if (replacement) {
+            replacement->parent = parent;
+        }
+    }
+
+    // REQUIRES: node has a parent
+    // EFFECTS:  rotates node above its parent, keeping the in-order walk
+    //           and the subtree sizes
+    void rotate_up(Node *node) {
+        Node *parent = node->parent;
+        replace_child(parent->parent, parent, node);
+        if (node == parent->left) {
+            parent->left = node->right;
+            if (node->right) {
+                node->right->parent = parent;
+            }
+            node->right = parent;
+        } else {
+            parent->right = node->left;
+            if (node->left) {
+                node->left->parent = parent;
+            }
+            node->left = parent;
+        }
+        parent->parent = node;
+        node->size = parent->size;
+        parent->size = 1 + size_of(parent->left) + size_of(parent->right);
+    }
+
+    // EFFECTS: adds delta to the size of node and each of its ancestors
+    static void add_to_sizes(Node *node, std::ptrdiff_t delta) {
+        for (; node; node = node->parent) {
+            node->size += delta;
+        }
+    }
+
+    // EFFECTS: copies the subtree rooted at node under the given parent,
+    //          keeping its shape, and returns the copy
+    Node *copy_tree(const Node *node, Node *parent) {
+        if (!node) {
+            return nullptr;
+        }
+        Node *copy = NodeTraits::allocate(node_alloc, 1);
+        try {
+            NodeTraits::construct(node_alloc, copy, Node{nullptr, nullptr, parent, node->size,
+                                                         node->priority, node->datum});
+        } catch (...) {
+            NodeTraits::deallocate(node_alloc, copy, 1);
+            throw;
+        }
+        try {
+            copy->left = copy_tree(node->left, copy);
+            copy->right = copy_tree(node->right, copy);
+        } catch (...) {
+            destroy_tree(copy);
+            throw;
+        }
+        return copy;
+    }
+
+    // EFFECTS: destroys and deallocates the subtree rooted at node
+    void destroy_tree(Node *node) {
+        while (node) {
+            destroy_tree(node->right);
+            Node *left = node->left;
+            NodeTraits::destroy(node_alloc, node);
+            NodeTraits::deallocate(node_alloc, node, 1);
+            node = left;
+        }
+    }
+
+   public:
+    ////////////////////////////////////////
+    template <typename Value>
+    class BasicIterator {
+        // OVERVIEW: bidirectional iterator over an IndexedList, whose
+        //           elements it yields as Value, which is T or const T. As
+        //           with List, the past-the-end iterator remembers its list,
+        //           so that decrementing it moves to the last element.
+       public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = std::remove_const_t<Value>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Value *;
+        using reference = Value &;
+
+        BasicIterator() : node_ptr(nullptr), list_ptr(nullptr) {
+        }
+
+        // EFFECTS: converts an Iterator to a ConstIterator
+        template <typename Other,
+                  typename = std::enable_if_t<std::is_same<const Other, Value>::value &&
+                                              !std::is_same<Other, Value>::value>>
+        BasicIterator(const BasicIterator<Other> &other)
+            : node_ptr(other.node_ptr), list_ptr(other.list_ptr) {
+        }
+
+        reference operator*() const {
+            return node_ptr->datum;
+        }
+
+        pointer operator->() const {
+            return &node_ptr->datum;
+        }
+
+        // moves to the in-order successor
+        BasicIterator &operator++() {
+            assert(node_ptr);
+            if (node_ptr->right) {
+                node_ptr = leftmost(node_ptr->right);
+            } else {
+                while (node_ptr->parent && node_ptr == node_ptr->parent->right) {
+                    node_ptr = node_ptr->parent;
+                }
+                node_ptr = node_ptr->parent;
+            }
+            return *this;
+        }
+
+        BasicIterator operator++(int) {
+            BasicIterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        // REQUIRES: the iterator is not at the first element, and was
+        //           obtained from a list (it is not default-constructed)
+        BasicIterator &operator--() {
+            assert(node_ptr || list_ptr);
+            if (!node_ptr) {
+                assert(list_ptr->root);
+                node_ptr = rightmost(list_ptr->root);
+            } else if (node_ptr->left) {
+                node_ptr = rightmost(node_ptr->left);
+            } else {
+                while (node_ptr->parent && node_ptr == node_ptr->parent->left) {
+                    node_ptr = node_ptr->parent;
+                }
+                node_ptr = node_ptr->parent;
+                assert(node_ptr);
+            }
+            return *this;
+        }
+
+        BasicIterator operator--(int) {
+            BasicIterator old = *this;
+            --*this;
+            return old;
+        }
+
+        template <typename Other>
+        bool operator==(const BasicIterator<Other> &other) const {
+            return node_ptr == other.node_ptr;
+        }
+
+        template <typename Other>
+        bool operator!=(const BasicIterator<Other> &other) const {
+            return node_ptr != other.node_ptr;
+        }
+
+       private:
+        Node *node_ptr;               // current position, or nullptr past the end
+        const IndexedList *list_ptr;  // the list, or nullptr if default-constructed
+
+        friend class IndexedList;
+        template <typename>
+        friend class BasicIterator;
+
+        // construct an Iterator at a specific position in the given list
+        BasicIterator(Node *p, const IndexedList *list) : node_ptr(p), list_ptr(list) {
+        }
+
+    };  // IndexedList::BasicIterator
+    ////////////////////////////////////////
+
+    using Iterator = BasicIterator<T>;
+    using ConstIterator = BasicIterator<const T>;
+    using ReverseIterator = std::reverse_iterator<Iterator>;
+    using ConstReverseIterator = std::reverse_iterator<ConstIterator>;
+
+    // names used by the standard containers, for generic code
+    using value_type = T;
+    using reference = T &;
+    using const_reference = const T &;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using iterator = Iterator;
+    using const_iterator = ConstIterator;
+    using reverse_iterator = ReverseIterator;
+    using const_reverse_iterator = ConstReverseIterator;
+
+    // return an Iterator pointing to the first element
+    Iterator begin() {
+        return Iterator(root ? leftmost(root) : nullptr, this);
+    }
+
+    ConstIterator begin() const {
+        return ConstIterator(root ? leftmost(root) : nullptr, this);
+    }
+
+    ConstIterator cbegin() const {
+        return begin();
+    }
+
+    // return an Iterator pointing to "past the end"
+    Iterator end() {
+        return Iterator(nullptr, this);
+    }
+
+    ConstIterator end() const {
+        return ConstIterator(nullptr, this);
+    }
+
+    ConstIterator cend() const {
+        return end();
+    }
+
+    // return reverse iterators, from the last element to "before the first"
+    ReverseIterator rbegin() {
+        return ReverseIterator(end());
+    }
+
+    ConstReverseIterator rbegin() const {
+        return ConstReverseIterator(end());
+    }
+
+    ConstReverseIterator crbegin() const {
+        return rbegin();
+    }
+
+    ReverseIterator rend() {
+        return ReverseIterator(begin());
+    }
+
+    ConstReverseIterator rend() const {
+        return ConstReverseIterator(begin());
+    }
+
+    ConstReverseIterator crend() const {
+        return rend();
+    }
+
+    // REQUIRES: 0 <= index <= size()
+    // EFFECTS:  returns an Iterator pointing to the element at the given
+    //           index, or end() if index is size()
+    Iterator iterator_at(int index) {
+        assert(0 <= index && index <= size());
+        Node *node = root;
+        std::size_t k = index;
+        while (node) {
+            std::size_t left_size = size_of(node->left);
+            if (k < left_size) {
+                node = node->left;
+            } else if (k == left_size) {
+                break;
+            } else {
+                k -= left_size + 1;
+                node = node->right;
+            }
+        }
+        return Iterator(node, this);
+    }
+
+    ConstIterator iterator_at(int index) const {
+        return const_cast<IndexedList *>(this)->iterator_at(index);
+    }
+
+    // REQUIRES: i is a valid iterator associated with this list
+    // EFFECTS:  returns the index of the element at i, or size() if i is
+    //           end()
+    int index_of(ConstIterator i) const {
+        const Node *node = i.node_ptr;
+        if (!node) {
+            return size();
+        }
+        std::size_t index = size_of(node->left);
+        for (; node->parent; node = node->parent) {
+            if (node == node->parent->right) {
+                index += size_of(node->parent->left) + 1;
+            }
+        }
+        return index;
+    }
+
+    // REQUIRES: i is a valid, dereferenceable iterator associated with this list
+    // MODIFIES: invalidates iterators to the erased element
+    // EFFECTS: Removes a single element from the list container
+    //          Returns An iterator pointing to the element that followed the element
+    //          erased by the function call
+    Iterator erase(Iterator i) {
+        Node *victim = i.node_ptr;
+        Iterator next = std::next(i);
+        // rotate the victim down until it has at most one child
+        while (victim->left && victim->right) {
+            rotate_up(victim->left->priority > victim->right->priority ? victim->left
+                                                                       : victim->right);
+        }
+        add_to_sizes(victim->parent, -1);
+        replace_child(victim->parent, victim, victim->left ? victim->left : victim->right);
+        NodeTraits::destroy(node_alloc, victim);
+        NodeTraits::deallocate(node_alloc, victim, 1);
+        return next;
+    }
+
+    // REQUIRES: i is a valid iterator associated with this list
+    // EFFECTS: inserts datum before the element at the specified position.
+    //          returns an iterator to the the newly inserted element
+    Iterator insert(Iterator i, const T &datum) {
+        Node *new_node = NodeTraits::allocate(node_alloc, 1);
+        try {
+            NodeTraits::construct(node_alloc, new_node,
+                                  Node{nullptr, nullptr, nullptr, 1, next_priority(), datum});
+        } catch (...) {
+            NodeTraits::deallocate(node_alloc, new_node, 1);
+            throw;
+        }
+        // add it as a leaf just before i, then rotate it up into place
+        Node *position = i.node_ptr;
+        if (!root) {
+            root = new_node;
+        } else if (!position) {
+            Node *last = rightmost(root);
+            last->right = new_node;
+            new_node->parent = last;
+        } else if (!position->left) {
+            position->left = new_node;
+            new_node->parent = position;
+        } else {
+            Node *prev = rightmost(position->left);
+            prev->right = new_node;
+            new_node->parent = prev;
+        }
+        add_to_sizes(new_node->parent, 1);
+        while (new_node->parent && new_node->priority > new_node->parent->priority) {
+            rotate_up(new_node);
+        }
+        return Iterator(new_node, this);
+    }
+
+};  // IndexedList
+
+#endif
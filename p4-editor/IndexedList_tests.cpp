@@ -0,0 +1,112 @@
+#include "IndexedList.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "unit_test_framework.hpp"
+
+using namespace std;
+
+// Helpers
+template <typename T>
+vector<T> contents(const IndexedList<T> &list);
+
+TEST(test_push_pop) {
+    IndexedList<int> list_int;
+    ASSERT_TRUE(list_int.empty());
+    ASSERT_TRUE(list_int.begin() == list_int.end());
+    list_int.push_back(2);
+    list_int.push_front(1);
+    list_int.push_back(3);
+    ASSERT_EQUAL(list_int.size(), 3);
+    ASSERT_EQUAL(list_int.front(), 1);
+    ASSERT_EQUAL(list_int.back(), 3);
+    list_int.pop_front();
+    list_int.pop_back();
+    ASSERT_TRUE(contents(list_int) == vector<int>({2}));
+    list_int.clear();
+    ASSERT_TRUE(list_int.empty());
+}
+
+TEST(test_iterator_at_and_index_of) {
+    IndexedList<int> list_int;
+    for (int i = 0; i < 1000; ++i) {
+        list_int.push_back(i);
+    }
+    for (int i = 0; i < 1000; i += 37) {
+        IndexedList<int>::Iterator it = list_int.iterator_at(i);
+        ASSERT_EQUAL(*it, i);
+        ASSERT_EQUAL(list_int.index_of(it), i);
+    }
+    ASSERT_TRUE(list_int.iterator_at(1000) == list_int.end());
+    ASSERT_EQUAL(list_int.index_of(list_int.end()), 1000);
+    const IndexedList<int> &const_list = list_int;
+    ASSERT_EQUAL(*const_list.iterator_at(999), 999);
+}
+
+TEST(test_insert_erase_at_position) {
+    IndexedList<int> list_int;
+    vector<int> reference;
+    unsigned state = 1;
+    for (int i = 0; i < 2000; ++i) {
+        state = state * 1103515245 + 12345;
+        int position = (state >> 8) % (reference.size() + 1);
+        if (i % 3 == 2 && !reference.empty()) {
+            position %= reference.size();
+            IndexedList<int>::Iterator next = list_int.erase(list_int.iterator_at(position));
+            reference.erase(reference.begin() + position);
+            ASSERT_EQUAL(list_int.index_of(next), position);
+        } else {
+            IndexedList<int>::Iterator inserted = list_int.insert(list_int.iterator_at(position), i);
+            reference.insert(reference.begin() + position, i);
+            ASSERT_EQUAL(list_int.index_of(inserted), position);
+        }
+    }
+    ASSERT_TRUE(contents(list_int) == reference);
+    ASSERT_EQUAL(list_int.size(), static_cast<int>(reference.size()));
+}
+
+TEST(test_iterators) {
+    IndexedList<string> list_str;
+    list_str.push_back("hello");
+    list_str.push_back("world");
+    list_str.push_back("again");
+    IndexedList<string>::Iterator last = list_str.end();
+    ASSERT_EQUAL(*--last, "again");
+    ASSERT_EQUAL(last->size(), 5u);
+    vector<string> reversed(list_str.crbegin(), list_str.crend());
+    ASSERT_TRUE(reversed == vector<string>({"again", "world", "hello"}));
+    IndexedList<string>::ConstIterator found = find(list_str.cbegin(), list_str.cend(), "world");
+    ASSERT_EQUAL(distance(list_str.cbegin(), found), 1);
+    IndexedList<string>::Iterator it = list_str.iterator_at(1);
+    list_str.erase(list_str.begin());  // iterators to other elements stay valid
+    ASSERT_EQUAL(*it, "world");
+    ASSERT_EQUAL(list_str.index_of(it), 0);
+}
+
+TEST(test_copy_and_assign) {
+    IndexedList<int> list_int;
+    for (int i = 0; i < 100; ++i) {
+        list_int.push_back(i);
+    }
+    IndexedList<int> list_copy(list_int);
+    list_copy.erase(list_copy.iterator_at(50));
+    ASSERT_EQUAL(*list_copy.iterator_at(50), 51);
+    ASSERT_EQUAL(*list_int.iterator_at(50), 50);
+    list_int = list_copy;
+    ASSERT_TRUE(contents(list_int) == contents(list_copy));
+    list_int = list_int;
+    ASSERT_EQUAL(list_int.size(), 99);
+    list_int.push_front(-1);  // the copied tree is still a treap
+    ASSERT_EQUAL(list_int.index_of(list_int.iterator_at(99)), 99);
+}
+
+// Returns the elements of the given list in order.
+template <typename T>
+vector<T> contents(const IndexedList<T> &list) {
+    return vector<T>(list.begin(), list.end());
+}
+
+TEST_MAIN()
@@ -0,0 +1,212 @@
+#ifndef LINE_INDEX_HPP
+#define LINE_INDEX_HPP
+/* LineIndex.hpp
+ *
+ * sparse index of the line starts in a text, built in parallel by
+ * background threads
+ */
+
+#include <algorithm>  // std::upper_bound
+#include <atomic>
+#include <cstddef>  // std::size_t
+#include <cstring>  // std::memchr
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class LineIndex {
+    // OVERVIEW: records the start of (at least) every interval-th line
+    //           of a text, so that any line can be found by scanning at
+    //           most 2 * interval lines from a checkpoint. The text is
+    //           split into chunks that are scanned in parallel; each
+    //           chunk records its newline count and its own checkpoints,
+    //           and finished chunks are merged in order with a prefix
+    //           sum of the counts. Lines in the merged prefix of the
+    //           text can be looked up while later chunks are scanned.
+   public:
+    static constexpr std::size_t DEFAULT_INTERVAL = 1024;        // lines per checkpoint
+    static constexpr std::size_t DEFAULT_CHUNK_SIZE = 1 << 24;  // bytes per chunk
+
+    // A line number (counting from 1) and the offset of its first byte.
+    struct Line {
+        std::size_t number;
+        std::size_t offset;
+    };
+
+    // Called with the bounds of each chunk once it has been scanned.
+    using ChunkCallback = std::function<void(std::size_t begin, std::size_t end)>;
+
+    // REQUIRES: text stays valid and unmodified until indexing is done
+    //           or this index is destroyed
+    // EFFECTS:  Starts indexing the given text with the given number of
+    //           threads, or one per core if threads is zero.
+    LineIndex(const char *text_in, std::size_t size_in, std::size_t interval_in = DEFAULT_INTERVAL,
+              unsigned threads = 0, std::size_t chunk_size = DEFAULT_CHUNK_SIZE,
+              ChunkCallback on_chunk_done_in = nullptr)
+        : text(text_in), size(size_in), interval(interval_in), on_chunk_done(on_chunk_done_in),
+          checkpoints(1, Line{1, 0}), merged_chunks(0), merged_lines(1), next_chunk(0),
+          stopping(false) {
+        // an empty text has no chunks, so the workers never search it
+        for (std::size_t begin = 0; begin < size; begin += chunk_size) {
+            chunks.push_back({begin, std::min(size, begin + chunk_size), 0, {}, false});
+        }
+        if (threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        threads = std::min<std::size_t>(threads, chunks.size());
+        for (unsigned i = 0; i < threads; ++i) {
+            workers.emplace_back(&LineIndex::scan_chunks, this);
+        }
+    }
+
+    // disable copying
+    LineIndex(const LineIndex &) = delete;
+    LineIndex &operator=(const LineIndex &) = delete;
+
+    ~LineIndex() {
+        stopping = true;
+        for (std::thread &worker : workers) {
+            worker.join();
+        }
+    }
+
+    // EFFECTS: Returns whether the whole text has been indexed.
+    bool done() const {
+        return merged_chunks == chunks.size();
+    }
+
+    // EFFECTS: Returns the number of lines that start in the indexed
+    //          prefix of the text. This is the number of lines in the
+    //          text once indexing is done.
+    std::size_t line_count() const {
+        return merged_lines;
+    }
+
+    // EFFECTS: Returns the line with the given number, or the last line
+    //          if the text has fewer lines. Lines after the indexed
+    //          prefix are found by scanning from its last checkpoint.
+    Line find_line(std::size_t number) const {
+        if (size == 0) {
+            return Line{1, 0};  // the text may be nullptr, which cannot be searched
+        }
+        Line line;
+        {
+            std::lock_guard<std::mutex> lock(checkpoints_mutex);
+            auto after = std::upper_bound(checkpoints.begin(), checkpoints.end(), number,
+                                          [](std::size_t target, const Line &checkpoint) {
+                                              return target < checkpoint.number;
+                                          });
+            line = *(after - 1);
+        }
+        const char *end = text + size;
+        for (const char *p = text + line.offset; line.number < number; ++line.number) {
+            p = static_cast<const char *>(std::memchr(p, '\n', end - p));
+            if (!p) {
+                break;  // no more lines
+            }
+            line.offset = ++p - text;
+        }
+        return line;
+    }
+
+    // REQUIRES: offset <= size of the text
+    // EFFECTS:  Returns the line containing the byte at the given offset.
+    Line line_containing(std::size_t offset) const {
+        if (size == 0) {
+            return Line{1, 0};  // the text may be nullptr, which cannot be searched
+        }
+        Line line;
+        {
+            std::lock_guard<std::mutex> lock(checkpoints_mutex);
+            auto after = std::upper_bound(checkpoints.begin(), checkpoints.end(), offset,
+                                          [](std::size_t target, const Line &checkpoint) {
+                                              return target < checkpoint.offset;
+                                          });
+            line = *(after - 1);
+        }
+        const char *target = text + offset;
+        for (const char *p = text + line.offset;
+             (p = static_cast<const char *>(std::memchr(p, '\n', target - p)));
+             line.offset = ++p - text, ++line.number)
+            ;
+        return line;
+    }
+
+   private:
+    struct Chunk {
+        std::size_t begin;
+        std::size_t end;
+        std::size_t newlines;
+        std::vector<Line> checkpoints;  // numbered relative to the chunk
+        bool scanned;
+    };
+
+    const char *text;
+    std::size_t size;
+    std::size_t interval;
+    ChunkCallback on_chunk_done;
+    std::vector<Chunk> chunks;
+    std::vector<Line> checkpoints;         // merged checkpoints, in order
+    mutable std::mutex checkpoints_mutex;  // guards chunks and checkpoints
+    std::atomic<std::size_t> merged_chunks;
+    std::atomic<std::size_t> merged_lines;
+    std::atomic<std::size_t> next_chunk;  // next chunk to be claimed
+    std::atomic<bool> stopping;
+    std::vector<std::thread> workers;  // must be initialized after the members they use
+    // INVARIANT: checkpoints holds the checkpoints of chunks
+    //            [0, merged_chunks), numbered from the start of the text,
+    //            and merged_lines is one more than the number of newlines
+    //            in those chunks
+
+    // MODIFIES: *this
+    // EFFECTS:  Claims and scans chunks until there are none left, then
+    //           merges each one that completes the indexed prefix.
+    void scan_chunks() {
+        for (std::size_t i; !stopping && (i = next_chunk++) < chunks.size();) {
+            // chunk bounds are never modified, so they can be read unlocked
+            std::size_t newlines = 0;
+            std::vector<Line> found;
+            const char *end = text + chunks[i].end;
+            for (const char *p = text + chunks[i].begin;
+                 (p = static_cast<const char *>(std::memchr(p, '\n', end - p)));) {
+                if (++newlines % interval == 0) {
+                    found.push_back({newlines, static_cast<std::size_t>(++p - text)});
+                } else {
+                    ++p;
+                }
+            }
+            if (on_chunk_done) {
+                on_chunk_done(chunks[i].begin, chunks[i].end);
+            }
+
+            std::lock_guard<std::mutex> lock(checkpoints_mutex);
+            chunks[i].newlines = newlines;
+            chunks[i].checkpoints.swap(found);
+            chunks[i].scanned = true;
+            merge_scanned_chunks();
+        }
+    }
+
+    // REQUIRES: checkpoints_mutex is held
+    // MODIFIES: *this
+    // EFFECTS:  Merges scanned chunks that directly follow the indexed
+    //           prefix, numbering their checkpoints by the prefix sum of
+    //           the newline counts before them.
+    void merge_scanned_chunks() {
+        std::size_t merged = merged_chunks;
+        std::size_t base = merged_lines;  // line containing the chunk's first byte
+        for (; merged < chunks.size() && chunks[merged].scanned; ++merged) {
+            Chunk &chunk = chunks[merged];
+            for (const Line &checkpoint : chunk.checkpoints) {
+                checkpoints.push_back({base + checkpoint.number, checkpoint.offset});
+            }
+            base += chunk.newlines;
+            std::vector<Line>().swap(chunk.checkpoints);  // no longer needed
+        }
+        merged_lines = base;
+        merged_chunks = merged;
+    }
+};
+
+#endif
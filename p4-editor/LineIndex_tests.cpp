@@ -0,0 +1,89 @@
+#include "LineIndex.hpp"
+
+#include <string>
+#include <thread>
+
+#include "unit_test_framework.hpp"
+
+using namespace std;
+
+// Helpers
+void wait_for_index(const LineIndex &index);
+string make_text(int lines);
+void check_all_lines(const LineIndex &index, const string &text);
+
+TEST(test_empty_text) {
+    LineIndex index("", 0);
+    ASSERT_TRUE(index.done());
+    ASSERT_EQUAL(index.line_count(), 1);
+    ASSERT_EQUAL(index.find_line(5).number, 1);
+    ASSERT_EQUAL(index.line_containing(0).offset, 0);
+    LineIndex unmapped(nullptr, 0);  // as for an empty file, which is not mapped
+    ASSERT_TRUE(unmapped.done());
+    ASSERT_EQUAL(unmapped.find_line(2).number, 1);
+    ASSERT_EQUAL(unmapped.find_line(2).offset, 0);
+    ASSERT_EQUAL(unmapped.line_containing(0).number, 1);
+}
+
+TEST(test_single_chunk) {
+    string text = make_text(50);
+    LineIndex index(text.data(), text.size(), 4, 1);
+    wait_for_index(index);
+    ASSERT_EQUAL(index.line_count(), 51);
+    check_all_lines(index, text);
+}
+
+TEST(test_many_chunks_many_threads) {
+    // chunk boundaries fall in the middle of lines and on newlines
+    string text = make_text(300);
+    for (size_t chunk_size : {1, 2, 7, 64}) {
+        LineIndex index(text.data(), text.size(), 3, 4, chunk_size);
+        wait_for_index(index);
+        ASSERT_EQUAL(index.line_count(), 301);
+        check_all_lines(index, text);
+    }
+}
+
+TEST(test_chunk_callback) {
+    string text = make_text(100);
+    size_t scanned = 0;  // only touched by the single worker
+    LineIndex index(text.data(), text.size(), 8, 1, 10,
+                    [&scanned](size_t begin, size_t end) { scanned += end - begin; });
+    wait_for_index(index);
+    ASSERT_EQUAL(scanned, text.size());
+}
+
+TEST_MAIN()
+
+// Helpers implementation
+void wait_for_index(const LineIndex &index) {
+    while (!index.done()) {
+        this_thread::yield();
+    }
+}
+
+// Lines of varying length, including empty ones, ending with a newline.
+string make_text(int lines) {
+    string text;
+    for (int i = 0; i < lines; ++i) {
+        text += string(i % 5, 'a' + i % 26) + "\n";
+    }
+    return text;
+}
+
+void check_all_lines(const LineIndex &index, const string &text) {
+    size_t number = 1;
+    size_t start = 0;
+    for (size_t offset = 0; offset <= text.size(); ++offset) {
+        LineIndex::Line line = index.line_containing(offset);
+        ASSERT_EQUAL(line.number, number);
+        ASSERT_EQUAL(line.offset, start);
+        if (offset == start) {
+            ASSERT_EQUAL(index.find_line(number).offset, start);
+        }
+        if (offset < text.size() && text[offset] == '\n') {
+            ++number;
+            start = offset + 1;
+        }
+    }
+}
@@ -2,30 +2,52 @@
 #define LIST_HPP
 /* List.hpp
  *
- * doubly-linked, double-ended list with Iterator interface
+ * doubly-linked, double-ended list with Iterator interface, and an
+ * intrusive variant whose elements hold their own links
  * EECS 280 Project 4
  */
 
 #include <cassert>  //assert
-#include <cstddef>  //NULL
+#include <cstddef>  //NULL, std::ptrdiff_t
+#include <functional>  //std::less
 #include <iostream>
+#include <iterator>  //std::bidirectional_iterator_tag, std::reverse_iterator
+#include <memory>  //std::allocator, std::allocator_traits
+#include <new>  //placement new, std::launder
+#include <type_traits>  //std::enable_if_t, std::remove_const_t
 
-template <typename T>
+template <typename T, typename Alloc = std::allocator<T>>
 class List {
-    // OVERVIEW: a doubly-linked, double-ended list with Iterator interface
+    // OVERVIEW: a doubly-linked, double-ended list with Iterator interface.
+    //           Nodes are allocated with (a copy of) the given allocator;
+    //           a copy of the list uses the allocator's
+    //           select_on_container_copy_construction, which for most
+    //           allocators shares it. A copy allocates all its nodes in
+    //           one block, in order, so that walking it reads memory
+    //           sequentially; nodes erased from the block are reused by
+    //           later insertions, and the block is freed once the list is
+    //           empty.
    public:
-    List() : first(nullptr), last(nullptr), sz(0) {
+    explicit List(const Alloc &alloc = Alloc())
+        : first(nullptr), last(nullptr), sz(0), node_alloc(alloc), block(nullptr),
+          block_size(0), block_used(0), free_nodes(nullptr) {
     }
 
-    List(const List &other) : List() {  // copy-ctor
+    List(const List &other)  // copy-ctor
+        : List(NodeTraits::select_on_container_copy_construction(other.node_alloc)) {
         copy_all(other);
     }
 
     List &operator=(const List &other) {  // overloaded assignment
-        List temp(other);
+        List temp(node_alloc);  // nodes must come from this list's allocator
+        temp.copy_all(other);
         std::swap(first, temp.first);
         std::swap(last, temp.last);
         std::swap(sz, temp.sz);
+        std::swap(block, temp.block);
+        std::swap(block_size, temp.block_size);
+        std::swap(block_used, temp.block_used);
+        std::swap(free_nodes, temp.free_nodes);
         return *this;
     }
 
@@ -33,6 +55,11 @@ class List {
         clear();
     }
 
+    // EFFECTS: returns a copy of the allocator used for the nodes
+    Alloc get_allocator() const {
+        return Alloc(node_alloc);
+    }
+
     // EFFECTS:  returns true if the list is empty
     bool empty() const {
         return sz == 0;
@@ -52,6 +79,11 @@ class List {
         return first->datum;
     }
 
+    const T &front() const {
+        assert(!empty());
+        return first->datum;
+    }
+
     // REQUIRES: list is not empty
     // EFFECTS: Returns the last element in the list by reference
     T &back() {
@@ -59,9 +91,14 @@ class List {
         return last->datum;
     }
 
+    const T &back() const {
+        assert(!empty());
+        return last->datum;
+    }
+
     // EFFECTS:  inserts datum into the front of the list
     void push_front(const T &datum) {
-        Node *new_node = new Node{first, nullptr, datum};
+        Node *new_node = create_node(first, nullptr, datum);
         if (empty()) {
             first = last = new_node;
         } else {
@@ -72,7 +109,7 @@ class List {
 
     // EFFECTS:  inserts datum into the back of the list
     void push_back(const T &datum) {
-        Node *new_node = new Node{nullptr, last, datum};
+        Node *new_node = create_node(nullptr, last, datum);
         if (empty()) {
             first = last = new_node;
         } else {
@@ -90,9 +127,14 @@ class List {
         first = victim->next;
         if (first) {
             first->prev = nullptr;
+        } else {
+            last = nullptr;
         }
-        delete victim;
+        destroy_node(victim);
         --sz;
+        if (empty()) {
+            release_block();
+        }
     }
 
     // REQUIRES: list is not empty
@@ -104,17 +146,25 @@ class List {
         last = victim->prev;
         if (last) {
             last->next = nullptr;
+        } else {
+            first = nullptr;
         }
-        delete victim;
+        destroy_node(victim);
         --sz;
+        if (empty()) {
+            release_block();
+        }
     }
 
     // MODIFIES: may invalidate list iterators
-    // EFFECTS:  removes all items from the list
+    // EFFECTS:  removes all items from the list, and frees the block even
+    //           if it was already empty, as after a copy that threw
+    //           before its first element was added
     void clear() {
         while (!empty()) {
             pop_front();
         }
+        release_block();
     }
 
     // You should add in a default constructor, destructor, copy constructor,
@@ -130,12 +180,70 @@ class List {
         T datum;
     };
 
+    using NodeAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<Node>;
+    using NodeTraits = std::allocator_traits<NodeAlloc>;
+
+    // EFFECTS: allocates and returns a node with the given links and
+    //          datum, reusing one in the block if there is one free
+    Node *create_node(Node *next, Node *prev, const T &datum) {
+        Node *node;
+        if (free_nodes) {
+            node = free_nodes;
+            free_nodes = *std::launder(reinterpret_cast<Node **>(node));
+        } else if (block_used < block_size) {
+            node = block + block_used++;
+        } else {
+            node = NodeTraits::allocate(node_alloc, 1);
+        }
+        try {
+            NodeTraits::construct(node_alloc, node, Node{next, prev, datum});
+        } catch (...) {
+            release_node(node);
+            throw;
+        }
+        return node;
+    }
+
+    // EFFECTS: destroys and deallocates the given node
+    void destroy_node(Node *node) {
+        NodeTraits::destroy(node_alloc, node);
+        release_node(node);
+    }
+
+    // EFFECTS: deallocates the given unconstructed node, or keeps it for
+    //          reuse if it is in the block
+    void release_node(Node *node) {
+        std::less<Node *> before;
+        if (block && !before(node, block) && before(node, block + block_size)) {
+            ::new (static_cast<void *>(node)) Node *(free_nodes);  // link it in its storage
+            free_nodes = node;
+        } else {
+            NodeTraits::deallocate(node_alloc, node, 1);
+        }
+    }
+
     // REQUIRES: list is empty
-    // EFFECTS:  copies all nodes from other to this
-    void copy_all(const List<T> &other) {
+    // EFFECTS:  deallocates the block, if any
+    void release_block() {
+        if (block) {
+            NodeTraits::deallocate(node_alloc, block, block_size);
+            block = free_nodes = nullptr;
+            block_size = block_used = 0;
+        }
+    }
+
+    // REQUIRES: list is empty
+    // EFFECTS:  copies all nodes from other to this, allocating them in
+    //           one block
+    void copy_all(const List &other) {
         clear();
-        for (Iterator it = other.begin(); it != other.end(); ++it) {
-            push_back(*it);
+        if (other.empty()) {
+            return;
+        }
+        block = NodeTraits::allocate(node_alloc, other.sz);
+        block_size = other.sz;
+        for (Node *node = other.first; node; node = node->next) {
+            push_back(node->datum);
         }
     }
 
@@ -144,70 +252,166 @@ class List {
 
     size_t sz;  // number of elements in the list
 
+    NodeAlloc node_alloc;  // allocates every Node in the list
+
+    Node *block;             // nodes allocated together by copy_all, or nullptr
+    std::size_t block_size;  // number of nodes in the block
+    std::size_t block_used;  // number of them handed out so far
+    Node *free_nodes;        // nodes in the block that were erased, to reuse
+
    public:
     ////////////////////////////////////////
-    class Iterator {
-        // OVERVIEW: Iterator interface to List
+    template <typename Value>
+    class BasicIterator {
+        // OVERVIEW: bidirectional iterator over a List, whose elements it
+        //           yields as Value, which is T or const T. The past-the-
+        //           end iterator remembers its list, so that decrementing
+        //           it moves to the last element; it compares equal to a
+        //           default-constructed iterator, since only the nodes
+        //           are compared.
+       public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = std::remove_const_t<Value>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Value *;
+        using reference = Value &;
 
-        // You should add in a default constructor, destructor, copy constructor,
-        // and overloaded assignment operator, if appropriate. If these operations
-        // will work correctly without defining these, you can omit them. A user
-        // of the class must be able to create, copy, assign, and destroy Iterators.
+        BasicIterator() : node_ptr(nullptr), list_ptr(nullptr) {
+        }
 
-       public:
-        Iterator() : node_ptr(nullptr) {
+        // EFFECTS: converts an Iterator to a ConstIterator
+        template <typename Other,
+                  typename = std::enable_if_t<std::is_same<const Other, Value>::value &&
+                                              !std::is_same<Other, Value>::value>>
+        BasicIterator(const BasicIterator<Other> &other)
+            : node_ptr(other.node_ptr), list_ptr(other.list_ptr) {
         }
 
-        // Your iterator should implement the following public operators: *,
-        // ++ (prefix), default constructor, == and !=.
-        T &operator*() const {
+        reference operator*() const {
             return node_ptr->datum;
         }
 
-        Iterator &operator++() {
+        pointer operator->() const {
+            return &node_ptr->datum;
+        }
+
+        BasicIterator &operator++() {
             assert(node_ptr);
             node_ptr = node_ptr->next;
             return *this;
         }
 
-        bool operator==(const Iterator &other) const {
-            return node_ptr == other.node_ptr;
+        BasicIterator operator++(int) {
+            BasicIterator old = *this;
+            ++*this;
+            return old;
         }
 
-        bool operator!=(const Iterator &other) const {
-            return node_ptr != other.node_ptr;
-        }
-
-        // This operator will be used to test your code. Do not modify it.
-        // Requires that the current element is dereferenceable.
-        Iterator &operator--() {
+        // REQUIRES: the iterator is not at the first element, and was
+        //           obtained from a list (it is not default-constructed)
+        BasicIterator &operator--() {
+            assert(node_ptr || list_ptr);
+            node_ptr = (node_ptr ? node_ptr->prev : list_ptr->last);
             assert(node_ptr);
-            node_ptr = node_ptr->prev;
             return *this;
         }
 
+        BasicIterator operator--(int) {
+            BasicIterator old = *this;
+            --*this;
+            return old;
+        }
+
+        template <typename Other>
+        bool operator==(const BasicIterator<Other> &other) const {
+            return node_ptr == other.node_ptr;
+        }
+
+        template <typename Other>
+        bool operator!=(const BasicIterator<Other> &other) const {
+            return node_ptr != other.node_ptr;
+        }
+
        private:
-        Node *node_ptr;  // current Iterator position is a List node
-        // add any additional necessary member variables here
+        Node *node_ptr;         // current Iterator position is a List node
+        const List *list_ptr;  // the list, or nullptr if default-constructed
 
-        // add any friend declarations here
         friend class List;
+        template <typename>
+        friend class BasicIterator;
 
-        // construct an Iterator at a specific position
-        Iterator(Node *p) : node_ptr(p) {
+        // construct an Iterator at a specific position in the given list
+        BasicIterator(Node *p, const List *list) : node_ptr(p), list_ptr(list) {
         }
 
-    };  // List::Iterator
+    };  // List::BasicIterator
     ////////////////////////////////////////
 
+    using Iterator = BasicIterator<T>;
+    using ConstIterator = BasicIterator<const T>;
+    using ReverseIterator = std::reverse_iterator<Iterator>;
+    using ConstReverseIterator = std::reverse_iterator<ConstIterator>;
+
+    // names used by the standard containers, for generic code
+    using value_type = T;
+    using reference = T &;
+    using const_reference = const T &;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using iterator = Iterator;
+    using const_iterator = ConstIterator;
+    using reverse_iterator = ReverseIterator;
+    using const_reverse_iterator = ConstReverseIterator;
+
     // return an Iterator pointing to the first element
-    Iterator begin() const {
-        return Iterator(first);
+    Iterator begin() {
+        return Iterator(first, this);
+    }
+
+    ConstIterator begin() const {
+        return ConstIterator(first, this);
+    }
+
+    ConstIterator cbegin() const {
+        return begin();
     }
 
     // return an Iterator pointing to "past the end"
-    Iterator end() const {
-        return Iterator();
+    Iterator end() {
+        return Iterator(nullptr, this);
+    }
+
+    ConstIterator end() const {
+        return ConstIterator(nullptr, this);
+    }
+
+    ConstIterator cend() const {
+        return end();
+    }
+
+    // return reverse iterators, from the last element to "before the first"
+    ReverseIterator rbegin() {
+        return ReverseIterator(end());
+    }
+
+    ConstReverseIterator rbegin() const {
+        return ConstReverseIterator(end());
+    }
+
+    ConstReverseIterator crbegin() const {
+        return rbegin();
+    }
+
+    ReverseIterator rend() {
+        return ReverseIterator(begin());
+    }
+
+    ConstReverseIterator rend() const {
+        return ConstReverseIterator(begin());
+    }
+
+    ConstReverseIterator crend() const {
+        return rend();
     }
 
     // REQUIRES: i is a valid, dereferenceable iterator associated with this list
@@ -229,9 +433,9 @@ class List {
         Node *next = victim->next;
         prev->next = next;
         next->prev = prev;
-        delete victim;
+        destroy_node(victim);
         --sz;
-        return Iterator(next);
+        return Iterator(next, this);
     }
 
     // REQUIRES: i is a valid iterator associated with this list
@@ -241,12 +445,15 @@ class List {
         if (i.node_ptr == first) {
             push_front(datum);
             return begin();
+        } else if (i.node_ptr == nullptr) {  // end()
+            push_back(datum);
+            return Iterator(last, this);
         } else {
-            Node *new_node = new Node{i.node_ptr, i.node_ptr->prev, datum};
+            Node *new_node = create_node(i.node_ptr, i.node_ptr->prev, datum);
             i.node_ptr->prev->next = new_node;
             i.node_ptr->prev = new_node;
             ++sz;
-            return Iterator(new_node);
+            return Iterator(new_node, this);
         }
     }
 
@@ -258,4 +465,323 @@ class List {
 // may add the Big Three if needed.  Do add the public member functions for
 // Iterator.
 
+template <typename T>
+class ListHook {
+    // OVERVIEW: the links of an element of an IntrusiveList, kept as a
+    //           member of the element. Copying an element does not copy
+    //           its links: the copy is in no list.
+   public:
+    ListHook() : next(nullptr), prev(nullptr) {
+    }
+
+    ListHook(const ListHook &) : ListHook() {
+    }
+
+    ListHook &operator=(const ListHook &) {
+        return *this;
+    }
+
+   private:
+    T *next;  // the next element in the list, or nullptr
+    T *prev;  // the previous element in the list, or nullptr
+
+    template <typename U, ListHook<U> U::*>
+    friend class IntrusiveList;
+};
+
+template <typename T, ListHook<T> T::*Hook>
+class IntrusiveList {
+    // OVERVIEW: a doubly-linked, double-ended list of elements that hold
+    //           their own links in the member Hook, so that listing them
+    //           allocates nothing. The list does not own its elements:
+    //           they must outlive their time in it, and each may be in
+    //           only one list through a given hook. Iterators work as
+    //           those of List, and an element can be unlinked given just
+    //           a reference to it.
+   public:
+    IntrusiveList() : first(nullptr), last(nullptr), sz(0) {
+    }
+
+    // disable copying, as the elements can only be in one list
+    IntrusiveList(const IntrusiveList &) = delete;
+    IntrusiveList &operator=(const IntrusiveList &) = delete;
+
+    ~IntrusiveList() {
+        clear();
+    }
+
+    // EFFECTS:  returns true if the list is empty
+    bool empty() const {
+        return sz == 0;
+    }
+
+    // EFFECTS: returns the number of elements in this list
+    int size() const {
+        return sz;
+    }
+
+    // REQUIRES: list is not empty
+    // EFFECTS: Returns the first element in the list by reference
+    T &front() {
+        assert(!empty());
+        return *first;
+    }
+
+    const T &front() const {
+        assert(!empty());
+        return *first;
+    }
+
+    // REQUIRES: list is not empty
+    // EFFECTS: Returns the last element in the list by reference
+    T &back() {
+        assert(!empty());
+        return *last;
+    }
+
+    const T &back() const {
+        assert(!empty());
+        return *last;
+    }
+
+    // REQUIRES: datum is in no list through Hook
+    // EFFECTS:  links datum into the front of the list
+    void push_front(T &datum) {
+        link(datum, nullptr, first);
+    }
+
+    // REQUIRES: datum is in no list through Hook
+    // EFFECTS:  links datum into the back of the list
+    void push_back(T &datum) {
+        link(datum, last, nullptr);
+    }
+
+    // REQUIRES: list is not empty
+    // MODIFIES: may invalidate list iterators
+    // EFFECTS:  unlinks the element at the front of the list
+    void pop_front() {
+        assert(!empty());
+        unlink(*first);
+    }
+
+    // REQUIRES: list is not empty
+    // MODIFIES: may invalidate list iterators
+    // EFFECTS:  unlinks the element at the back of the list
+    void pop_back() {
+        assert(!empty());
+        unlink(*last);
+    }
+
+    // MODIFIES: may invalidate list iterators
+    // EFFECTS:  unlinks all elements from the list
+    void clear() {
+        while (!empty()) {
+            pop_front();
+        }
+    }
+
+    // REQUIRES: datum is in this list
+    // MODIFIES: may invalidate iterators to datum
+    // EFFECTS:  unlinks datum from the list in constant time
+    void unlink(T &datum) {
+        ListHook<T> &hook = datum.*Hook;
+        (hook.prev ? (hook.prev->*Hook).next : first) = hook.next;
+        (hook.next ? (hook.next->*Hook).prev : last) = hook.prev;
+        hook.next = hook.prev = nullptr;
+        --sz;
+    }
+
+    ////////////////////////////////////////
+    template <typename Value>
+    class BasicIterator {
+        // OVERVIEW: bidirectional iterator over an IntrusiveList, whose
+        //           elements it yields as Value, which is T or const T. As
+        //           with List, the past-the-end iterator remembers its list,
+        //           so that decrementing it moves to the last element.
+       public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = std::remove_const_t<Value>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Value *;
+        using reference = Value &;
+
+        BasicIterator() : node_ptr(nullptr), list_ptr(nullptr) {
+        }
+
+        // EFFECTS: converts an Iterator to a ConstIterator
+        template <typename Other,
+                  typename = std::enable_if_t<std::is_same<const Other, Value>::value &&
+                                              !std::is_same<Other, Value>::value>>
+        BasicIterator(const BasicIterator<Other> &other)
+            : node_ptr(other.node_ptr), list_ptr(other.list_ptr) {
+        }
+
+        reference operator*() const {
+            return *node_ptr;
+        }
+
+        pointer operator->() const {
+            return node_ptr;
+        }
+
+        BasicIterator &operator++() {
+            assert(node_ptr);
+            node_ptr = (node_ptr->*Hook).next;
+            return *this;
+        }
+
+        BasicIterator operator++(int) {
+            BasicIterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        // REQUIRES: the iterator is not at the first element, and was
+        //           obtained from a list (it is not default-constructed)
+        BasicIterator &operator--() {
+            assert(node_ptr || list_ptr);
+            node_ptr = (node_ptr ? (node_ptr->*Hook).prev : list_ptr->last);
+            assert(node_ptr);
+            return *this;
+        }
+
+        BasicIterator operator--(int) {
+            BasicIterator old = *this;
+            --*this;
+            return old;
+        }
+
+        template <typename Other>
+        bool operator==(const BasicIterator<Other> &other) const {
+            return node_ptr == other.node_ptr;
+        }
+
+        template <typename Other>
+        bool operator!=(const BasicIterator<Other> &other) const {
+            return node_ptr != other.node_ptr;
+        }
+
+       private:
+        T *node_ptr;                    // current position, an element of the list
+        const IntrusiveList *list_ptr;  // the list, or nullptr if default-constructed
+
+        friend class IntrusiveList;
+        template <typename>
+        friend class BasicIterator;
+
+        // construct an Iterator at a specific position in the given list
+        BasicIterator(T *p, const IntrusiveList *list) : node_ptr(p), list_ptr(list) {
+        }
+
+    };  // IntrusiveList::BasicIterator
+    ////////////////////////////////////////
+
+    using Iterator = BasicIterator<T>;
+    using ConstIterator = BasicIterator<const T>;
+    using ReverseIterator = std::reverse_iterator<Iterator>;
+    using ConstReverseIterator = std::reverse_iterator<ConstIterator>;
+
+    // names used by the standard containers, for generic code
+    using value_type = T;
+    using reference = T &;
+    using const_reference = const T &;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using iterator = Iterator;
+    using const_iterator = ConstIterator;
+    using reverse_iterator = ReverseIterator;
+    using const_reverse_iterator = ConstReverseIterator;
+
+    Iterator begin() {
+        return Iterator(first, this);
+    }
+
+    ConstIterator begin() const {
+        return ConstIterator(first, this);
+    }
+
+    ConstIterator cbegin() const {
+        return begin();
+    }
+
+    Iterator end() {
+        return Iterator(nullptr, this);
+    }
+
+    ConstIterator end() const {
+        return ConstIterator(nullptr, this);
+    }
+
+    ConstIterator cend() const {
+        return end();
+    }
+
+    ReverseIterator rbegin() {
+        return ReverseIterator(end());
+    }
+
+    ConstReverseIterator rbegin() const {
+        return ConstReverseIterator(end());
+    }
+
+    ConstReverseIterator crbegin() const {
+        return rbegin();
+    }
+
+    ReverseIterator rend() {
+        return ReverseIterator(begin());
+    }
+
+    ConstReverseIterator rend() const {
+        return ConstReverseIterator(begin());
+    }
+
+    ConstReverseIterator crend() const {
+        return rend();
+    }
+
+    // REQUIRES: datum is in this list
+    // EFFECTS:  returns an Iterator pointing to datum
+    Iterator iterator_to(T &datum) {
+        return Iterator(&datum, this);
+    }
+
+    // REQUIRES: i is a valid, dereferenceable iterator associated with this list
+    // MODIFIES: may invalidate other list iterators
+    // EFFECTS: unlinks the element at i, and returns an iterator pointing to
+    //          the element that followed it
+    Iterator erase(Iterator i) {
+        Iterator next = std::next(i);
+        unlink(*i);
+        return next;
+    }
+
+    // REQUIRES: i is a valid iterator associated with this list, and datum
+    //           is in no list through Hook
+    // EFFECTS: links datum in before the element at the specified position,
+    //          and returns an iterator pointing to it
+    Iterator insert(Iterator i, T &datum) {
+        link(datum, i.node_ptr ? (i.node_ptr->*Hook).prev : last, i.node_ptr);
+        return Iterator(&datum, this);
+    }
+
+   private:
+    T *first;  // the first element in the list, or nullptr if list is empty
+    T *last;   // the last element in the list, or nullptr if list is empty
+
+    size_t sz;  // number of elements in the list
+
+    // REQUIRES: prev and next are adjacent in the list, or nullptr at its ends
+    // EFFECTS:  links datum in between prev and next
+    void link(T &datum, T *prev, T *next) {
+        ListHook<T> &hook = datum.*Hook;
+        assert(!hook.next && !hook.prev && first != &datum);
+        hook.prev = prev;
+        hook.next = next;
+        (prev ? (prev->*Hook).next : first) = &datum;
+        (next ? (next->*Hook).prev : last) = &datum;
+        ++sz;
+    }
+};  // IntrusiveList
+
 #endif  // Do not remove this. Write all your code above this line.
@@ -0,0 +1,263 @@
+#include "IndexedList.hpp"
+#include "List.hpp"
+#include "SmallList.hpp"
+
+#include <algorithm>  // std::shuffle
+#include <random>
+#include <vector>
+
+#include "unit_test_framework.hpp"
+
+using namespace std;
+
+const int SIZE = 1000;
+const int LARGE_SIZE = 1 << 20;  // elements in the scan benchmarks, far beyond the caches
+const int SMALL_SIZE = 3;        // elements in the small list benchmarks
+const int INDEXED_SIZE = 100000;  // elements in the positional access benchmarks
+
+struct Job {
+    int id;
+    ListHook<Job> hook;
+};
+
+// Helpers
+void fill_list(List<int> &target, int size);
+void fill_scattered(List<int> &target, int size);
+const List<int> &scattered_list();
+const List<int> &copied_list();
+long sum_list(const List<int> &list_int);
+
+BENCH(bench_push_back) {
+    state.set_items_per_iteration(SIZE);
+    while (state.keep_running()) {
+        List<int> list_int;
+        for (int i = 0; i < SIZE; ++i) {
+            list_int.push_back(i);
+        }
+        DoNotOptimize(list_int.back());
+    }
+}
+
+BENCH(bench_iterate) {
+    List<int> list_int;
+    fill_list(list_int, SIZE);
+    state.set_items_per_iteration(SIZE);
+    while (state.keep_running()) {
+        long sum = 0;
+        for (List<int>::Iterator it = list_int.begin(); it != list_int.end(); ++it) {
+            sum += *it;
+        }
+        DoNotOptimize(sum);
+    }
+}
+
+BENCH(bench_insert_erase_middle) {
+    List<int> list_int;
+    fill_list(list_int, SIZE);
+    List<int>::Iterator middle = list_int.begin();
+    for (int i = 0; i < SIZE / 2; ++i) {
+        ++middle;
+    }
+    while (state.keep_running()) {
+        List<int>::Iterator inserted = list_int.insert(middle, 42);
+        list_int.erase(inserted);
+        ClobberMemory();
+    }
+}
+
+BENCH(bench_copy) {
+    List<int> list_int;
+    fill_list(list_int, SIZE);
+    state.set_items_per_iteration(SIZE);
+    while (state.keep_running()) {
+        List<int> list_copy(list_int);
+        DoNotOptimize(list_copy.front());
+    }
+}
+
+// Scans of a list whose nodes are scattered across the heap, as they are
+// after a long run of insertions and erasures, and of a copy of it, whose
+// nodes are allocated in order in one block.
+BENCH(bench_scan_scattered) {
+    const List<int> &list_int = scattered_list();
+    state.set_items_per_iteration(LARGE_SIZE);
+    while (state.keep_running()) {
+        DoNotOptimize(sum_list(list_int));
+    }
+}
+
+BENCH(bench_scan_copied) {
+    const List<int> &list_int = copied_list();
+    state.set_items_per_iteration(LARGE_SIZE);
+    while (state.keep_running()) {
+        DoNotOptimize(sum_list(list_int));
+    }
+}
+
+// Building and copying lists of a few elements, which a SmallList holds
+// without allocating.
+BENCH(bench_build_small) {
+    while (state.keep_running()) {
+        List<int> list_int;
+        for (int i = 0; i < SMALL_SIZE; ++i) {
+            list_int.push_back(i);
+        }
+        DoNotOptimize(list_int.back());
+    }
+}
+
+BENCH(bench_build_small_inline) {
+    while (state.keep_running()) {
+        SmallList<int> list_int;
+        for (int i = 0; i < SMALL_SIZE; ++i) {
+            list_int.push_back(i);
+        }
+        DoNotOptimize(list_int.back());
+    }
+}
+
+BENCH(bench_copy_small) {
+    List<int> list_int;
+    fill_list(list_int, SMALL_SIZE);
+    while (state.keep_running()) {
+        List<int> list_copy(list_int);
+        DoNotOptimize(list_copy.front());
+    }
+}
+
+BENCH(bench_copy_small_inline) {
+    SmallList<int> list_int;
+    for (int i = 0; i < SMALL_SIZE; ++i) {
+        list_int.push_back(i);
+    }
+    while (state.keep_running()) {
+        SmallList<int> list_copy(list_int);
+        DoNotOptimize(list_copy.front());
+    }
+}
+
+// A queue of objects that already live elsewhere, as in an LRU list: each
+// one is moved from the front to the back. A List of pointers allocates a
+// node for each move, and an IntrusiveList only relinks the object.
+BENCH(bench_requeue) {
+    static vector<Job> jobs(SIZE);
+    List<Job *> queue;
+    for (Job &job : jobs) {
+        queue.push_back(&job);
+    }
+    while (state.keep_running()) {
+        Job *job = queue.front();
+        queue.pop_front();
+        queue.push_back(job);
+        DoNotOptimize(queue.front());
+    }
+}
+
+BENCH(bench_requeue_intrusive) {
+    static vector<Job> jobs(SIZE);
+    IntrusiveList<Job, &Job::hook> queue;
+    for (Job &job : jobs) {
+        queue.push_back(job);
+    }
+    while (state.keep_running()) {
+        Job &job = queue.front();
+        queue.pop_front();
+        queue.push_back(job);
+        DoNotOptimize(&queue.front());
+    }
+}
+
+// Reaching the element at a pseudo-random index, by walking a List from
+// its start and with the tree of an IndexedList.
+BENCH(bench_seek_walk) {
+    static List<int> list_int;
+    if (list_int.empty()) {
+        fill_list(list_int, INDEXED_SIZE);
+    }
+    unsigned index = 0;
+    while (state.keep_running()) {
+        index = (index + 40503) % INDEXED_SIZE;
+        List<int>::Iterator it = list_int.begin();
+        for (unsigned i = 0; i < index; ++i) {
+            ++it;
+        }
+        DoNotOptimize(*it);
+    }
+}
+
+BENCH(bench_seek_indexed) {
+    static IndexedList<int> list_int;
+    if (list_int.empty()) {
+        for (int i = 0; i < INDEXED_SIZE; ++i) {
+            list_int.push_back(i);
+        }
+    }
+    unsigned index = 0;
+    while (state.keep_running()) {
+        index = (index + 40503) % INDEXED_SIZE;
+        DoNotOptimize(*list_int.iterator_at(index));
+    }
+}
+
+BENCH(bench_iterate_indexed) {
+    IndexedList<int> list_int;
+    for (int i = 0; i < SIZE; ++i) {
+        list_int.push_back(i);
+    }
+    state.set_items_per_iteration(SIZE);
+    while (state.keep_running()) {
+        long sum = 0;
+        for (int datum : list_int) {
+            sum += datum;
+        }
+        DoNotOptimize(sum);
+    }
+}
+
+void fill_list(List<int> &target, int size) {
+    for (int i = 0; i < size; ++i) {
+        target.push_back(i);
+    }
+}
+
+// Fills the list with nodes in random places on the heap, by erasing the
+// nodes of another list in random order and reusing their memory.
+void fill_scattered(List<int> &target, int size) {
+    List<int> scratch;
+    fill_list(scratch, size);
+    vector<List<int>::Iterator> nodes;
+    for (List<int>::Iterator it = scratch.begin(); it != scratch.end(); ++it) {
+        nodes.push_back(it);
+    }
+    shuffle(nodes.begin(), nodes.end(), mt19937(280));
+    for (List<int>::Iterator node : nodes) {
+        scratch.erase(node);
+    }
+    fill_list(target, size);
+}
+
+// Returns the scattered list of LARGE_SIZE elements, built on first use
+// and shared by the benchmarks.
+const List<int> &scattered_list() {
+    static List<int> list_int;
+    if (list_int.empty()) {
+        fill_scattered(list_int, LARGE_SIZE);
+    }
+    return list_int;
+}
+
+// Returns a copy of the scattered list, built on first use.
+const List<int> &copied_list() {
+    static List<int> list_int(scattered_list());
+    return list_int;
+}
+
+long sum_list(const List<int> &list_int) {
+    long sum = 0;
+    for (List<int>::ConstIterator it = list_int.begin(); it != list_int.end(); ++it) {
+        sum += *it;
+    }
+    return sum;
+}
+
+TEST_MAIN()
@@ -1,4 +1,15 @@
 #include "List.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <numeric>  // std::accumulate
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "CountingAllocator.hpp"
+
+#define UNIT_TEST_COUNT_ALLOCATIONS 1
 #include "unit_test_framework.hpp"
 
 using namespace std;
@@ -14,6 +25,24 @@ void create_singleton_list_string(List<string> &target);
 template <typename T>
 void print_list(List<T> &list);
 
+// An int whose copies throw while copies_fail is set and it is negative.
+struct FragileInt {
+    static bool copies_fail;
+    int value;
+
+    FragileInt(int value_in) : value(value_in) {}
+
+    FragileInt(const FragileInt &other) : value(other.value) {
+        if (copies_fail && value < 0) {
+            throw runtime_error("copy failed");
+        }
+    }
+
+    FragileInt &operator=(const FragileInt &) = default;
+};
+
+bool FragileInt::copies_fail = false;
+
 TEST(test_ctor_empty) {
     // Test empty ctor and .empty()
     List<int> list_int;
@@ -89,6 +118,7 @@ TEST(test_pop_front_single_elem) {
     singleton_int.pop_front();
     // list is now empty
     ASSERT_TRUE(singleton_int.empty());
+    ASSERT_TRUE(singleton_int.begin() == singleton_int.end());
 
     // string
     List<string> singleton_string;
@@ -105,6 +135,9 @@ TEST(test_pop_back_single_elem) {
     singleton_int.pop_back();
     // list is now empty
     ASSERT_TRUE(singleton_int.empty());
+    ASSERT_TRUE(singleton_int.begin() == singleton_int.end());
+    singleton_int.push_front(4);
+    ASSERT_EQUAL(singleton_int.back(), 4);
 
     // string
     List<string> singleton_string;
@@ -227,6 +260,273 @@ TEST(test_insert) {
     create_list_int(list_int_three);
     ASSERT_EQUAL(list_int.size(), 3);
     ASSERT_TRUE(are_lists_equal(list_int, list_int_three));
+
+    // insert at the end of a nonempty list
+    List<int>::Iterator it_fourth = list_int.insert(list_int.end(), 4);
+    ASSERT_EQUAL(*it_fourth, 4);
+    ASSERT_EQUAL(list_int.back(), 4);
+    ASSERT_EQUAL(list_int.size(), 4);
+}
+
+TEST(test_counting_allocator) {
+    AllocationCounts counts;
+    AllocationCounts other_counts;
+    {
+        List<int, CountingAllocator<int>> list_int{CountingAllocator<int>(&counts)};
+        list_int.push_back(1);
+        list_int.push_front(0);
+        list_int.insert(++list_int.begin(), 2);
+        ASSERT_EQUAL(counts.allocations, 3);
+        ASSERT_TRUE(counts.live_bytes >= 3 * sizeof(int));
+        ASSERT_EQUAL(&list_int.get_allocator().get_counts(), &counts);
+
+        // a copy shares the allocator, but assignment keeps its own; both
+        // allocate their nodes in one block
+        List<int, CountingAllocator<int>> list_copy = list_int;
+        ASSERT_EQUAL(counts.allocations, 4);
+        List<int, CountingAllocator<int>> list_other{CountingAllocator<int>(&other_counts)};
+        list_other = list_int;
+        ASSERT_EQUAL(counts.allocations, 4);
+        ASSERT_EQUAL(other_counts.allocations, 1);
+
+        list_int.pop_front();
+        list_int.erase(list_int.begin());
+        ASSERT_EQUAL(counts.deallocations, 2);
+    }
+    ASSERT_EQUAL(counts.deallocations, 4);
+    ASSERT_EQUAL(counts.live_bytes, 0u);
+    ASSERT_EQUAL(counts.peak_bytes, counts.total_bytes);
+    ASSERT_EQUAL(other_counts.live_bytes, 0u);
+}
+
+TEST(test_copy_block) {
+    List<int> list_int;
+    for (int i = 0; i < 5; ++i) {
+        list_int.push_back(i);
+    }
+    List<int> list_copy;
+    ASSERT_ALLOCATIONS_AT_MOST(1, list_copy = list_int);
+    // nodes erased from the block are reused, in any order
+    list_copy.erase(++list_copy.begin());
+    list_copy.pop_back();
+    ASSERT_ALLOCATIONS_AT_MOST(0, list_copy.push_front(-1));
+    ASSERT_ALLOCATIONS_AT_MOST(0, list_copy.insert(++list_copy.begin(), 9));
+    ASSERT_ALLOCATIONS_AT_MOST(1, list_copy.push_back(7));
+    int expected[] = {-1, 9, 0, 2, 3, 7};
+    int i = 0;
+    for (int datum : list_copy) {
+        ASSERT_EQUAL(datum, expected[i++]);
+    }
+    ASSERT_EQUAL(i, 6);
+    list_copy.clear();  // frees the block
+    list_copy.push_back(1);
+    ASSERT_EQUAL(list_copy.front(), 1);
+    List<int> empty_copy = List<int>();
+    ASSERT_TRUE(empty_copy.empty());
+}
+
+TEST(test_copy_throws) {
+    using FragileList = List<FragileInt, CountingAllocator<FragileInt>>;
+    AllocationCounts counts;
+    {
+        FragileList first_fails{CountingAllocator<FragileInt>(&counts)};
+        first_fails.push_back(-1);
+        first_fails.push_back(1);
+        FragileList later_fails{CountingAllocator<FragileInt>(&counts)};
+        for (int value : {0, 1, -1, 2}) {
+            later_fails.push_back(value);
+        }
+        FragileList target{CountingAllocator<FragileInt>(&counts)};
+        target.push_back(5);
+        FragileInt::copies_fail = true;
+        for (FragileList *source : {&first_fails, &later_fails}) {
+            bool threw = false;
+            try {
+                FragileList copy(*source);
+            } catch (const runtime_error &) {
+                threw = true;
+            }
+            ASSERT_TRUE(threw);
+            threw = false;
+            try {
+                target = *source;
+            } catch (const runtime_error &) {
+                threw = true;
+            }
+            ASSERT_TRUE(threw);
+            ASSERT_EQUAL(target.size(), 1);  // unchanged by the failed assignment
+            ASSERT_EQUAL(target.front().value, 5);
+        }
+        FragileInt::copies_fail = false;
+    }
+    ASSERT_EQUAL(counts.live_bytes, 0u);  // no node or block leaked
+}
+
+TEST(test_iterator_traits) {
+    using Traits = iterator_traits<List<int>::Iterator>;
+    static_assert(is_same<Traits::iterator_category, bidirectional_iterator_tag>::value, "");
+    static_assert(is_same<Traits::value_type, int>::value, "");
+    static_assert(is_same<Traits::reference, int &>::value, "");
+    static_assert(is_same<iterator_traits<List<int>::ConstIterator>::reference, const int &>::value,
+                  "");
+    static_assert(is_convertible<List<int>::Iterator, List<int>::ConstIterator>::value, "");
+    static_assert(!is_convertible<List<int>::ConstIterator, List<int>::Iterator>::value, "");
+    static_assert(is_same<decltype(declval<const List<int> &>().begin()),
+                          List<int>::ConstIterator>::value,
+                  "");
+#if __cplusplus >= 202002L
+    static_assert(bidirectional_iterator<List<int>::Iterator>);
+    static_assert(bidirectional_iterator<List<int>::ConstIterator>);
+#endif
+}
+
+TEST(test_decrement_end) {
+    List<int> list_int;
+    create_list_int(list_int);  // 1 2 3
+    List<int>::Iterator it = list_int.end();
+    ASSERT_EQUAL(*--it, 3);
+    ASSERT_EQUAL(*prev(list_int.end(), 3), 1);
+    ASSERT_TRUE(list_int.end() == List<int>::Iterator());  // only the nodes are compared
+    it = list_int.end();
+    ASSERT_TRUE(it-- == list_int.end());
+    ASSERT_EQUAL(*it, 3);
+    ASSERT_EQUAL(*it++, 3);
+    ASSERT_TRUE(it == list_int.end());
+    list_int.push_back(4);  // end() is still valid after insertions
+    ASSERT_EQUAL(*--it, 4);
+}
+
+TEST(test_reverse_iterators) {
+    List<int> list_int;
+    create_list_int(list_int);
+    vector<int> reversed(list_int.rbegin(), list_int.rend());
+    ASSERT_TRUE(reversed == vector<int>({3, 2, 1}));
+    *list_int.rbegin() = 30;
+    ASSERT_EQUAL(list_int.back(), 30);
+    const List<int> &const_list = list_int;
+    ASSERT_EQUAL(*const_list.crbegin(), 30);
+    ASSERT_EQUAL(distance(const_list.rbegin(), const_list.rend()), 3);
+    List<int> empty;
+    ASSERT_TRUE(empty.rbegin() == empty.rend());
+}
+
+TEST(test_const_iterators) {
+    List<string> list_string;
+    create_list_string(list_string);
+    const List<string> &const_list = list_string;
+    List<string>::ConstIterator it = const_list.begin();
+    ASSERT_EQUAL(it->size(), 11u);
+    ASSERT_EQUAL(*it, "hello world");
+    List<string>::ConstIterator from_mutable = list_string.begin();  // converts
+    ASSERT_TRUE(from_mutable == it);
+    ASSERT_TRUE(list_string.begin() == const_list.cbegin());
+    ASSERT_TRUE(const_list.cend() == list_string.end());
+    ASSERT_EQUAL(const_list.front(), "hello world");
+    ASSERT_EQUAL(const_list.back(), "project 4 is wack");
+    list_string.begin()->append("!");
+    ASSERT_EQUAL(*it, "hello world!");
+}
+
+TEST(test_standard_algorithms) {
+    List<int> list_int;
+    for (int i : {5, 3, 8, 1, 9, 2}) {
+        list_int.push_back(i);
+    }
+    ASSERT_EQUAL(accumulate(list_int.begin(), list_int.end(), 0), 28);
+    ASSERT_EQUAL(*find(list_int.begin(), list_int.end(), 8), 8);
+    ASSERT_EQUAL(count_if(list_int.cbegin(), list_int.cend(), [](int i) { return i > 4; }), 3);
+    ASSERT_EQUAL(*max_element(list_int.begin(), list_int.end()), 9);
+    reverse(list_int.begin(), list_int.end());  // needs bidirectional iterators
+    ASSERT_TRUE(vector<int>(list_int.begin(), list_int.end()) ==
+                vector<int>({2, 9, 1, 8, 3, 5}));
+    // find the last element less than 3 scanning backward
+    auto last_small =
+        find_if(list_int.rbegin(), list_int.rend(), [](int i) { return i < 3; });
+    ASSERT_EQUAL(*last_small, 1);
+    ASSERT_EQUAL(distance(list_int.begin(), last_small.base()), 3);
+    List<int> copied;
+    copy(list_int.rbegin(), list_int.rend(), back_inserter(copied));
+    ASSERT_TRUE(equal(copied.begin(), copied.end(), list_int.rbegin(), list_int.rend()));
+}
+
+struct Job {
+    int id;
+    ListHook<Job> hook;
+};
+
+using JobList = IntrusiveList<Job, &Job::hook>;
+
+TEST(test_intrusive_push_pop) {
+    vector<Job> jobs = {{0, {}}, {1, {}}, {2, {}}, {3, {}}};
+    JobList list_job;
+    ASSERT_ALLOCATIONS_AT_MOST(0, list_job.push_back(jobs[1]); list_job.push_back(jobs[2]));
+    list_job.push_front(jobs[0]);
+    list_job.insert(list_job.end(), jobs[3]);
+    ASSERT_EQUAL(list_job.size(), 4);
+    ASSERT_EQUAL(&list_job.front(), &jobs[0]);
+    ASSERT_EQUAL(&list_job.back(), &jobs[3]);
+    list_job.pop_front();
+    list_job.pop_back();
+    ASSERT_EQUAL(list_job.front().id, 1);
+    ASSERT_EQUAL(list_job.back().id, 2);
+    list_job.push_front(jobs[3]);  // relinked after being popped
+    ASSERT_EQUAL(list_job.front().id, 3);
+    list_job.clear();
+    ASSERT_TRUE(list_job.empty());
+    list_job.push_back(jobs[2]);
+    ASSERT_EQUAL(list_job.size(), 1);
+}
+
+TEST(test_intrusive_unlink) {
+    vector<Job> jobs = {{0, {}}, {1, {}}, {2, {}}, {3, {}}};
+    JobList list_job;
+    for (Job &job : jobs) {
+        list_job.push_back(job);
+    }
+    list_job.unlink(jobs[2]);  // in the middle
+    list_job.unlink(jobs[0]);  // at the front
+    list_job.unlink(jobs[3]);  // at the back
+    ASSERT_EQUAL(list_job.size(), 1);
+    ASSERT_EQUAL(&list_job.front(), &jobs[1]);
+    ASSERT_EQUAL(&list_job.back(), &jobs[1]);
+    list_job.unlink(jobs[1]);
+    ASSERT_TRUE(list_job.empty());
+    ASSERT_TRUE(list_job.begin() == list_job.end());
+}
+
+TEST(test_intrusive_iterators) {
+    vector<Job> jobs = {{0, {}}, {1, {}}, {2, {}}, {3, {}}};
+    JobList list_job;
+    for (Job &job : jobs) {
+        list_job.push_back(job);
+    }
+    JobList::Iterator it = list_job.iterator_to(jobs[1]);
+    it = list_job.erase(it);
+    ASSERT_EQUAL(it->id, 2);
+    it = list_job.insert(it, jobs[1]);  // back where it was
+    ASSERT_EQUAL(it->id, 1);
+    ASSERT_EQUAL((--list_job.end())->id, 3);
+    vector<int> ids;
+    for (JobList::ConstReverseIterator rit = list_job.crbegin(); rit != list_job.crend(); ++rit) {
+        ids.push_back(rit->id);
+    }
+    ASSERT_TRUE(ids == vector<int>({3, 2, 1, 0}));
+    JobList::ConstIterator found =
+        find_if(list_job.cbegin(), list_job.cend(), [](const Job &job) { return job.id == 2; });
+    ASSERT_EQUAL(&*found, &jobs[2]);
+    Job copy = jobs[2];  // a copy is in no list
+    list_job.push_front(copy);
+    ASSERT_EQUAL(list_job.size(), 5);
+    list_job.unlink(copy);
+}
+
+TEST(test_allocation_budget) {
+    List<int> list_int;
+    ASSERT_ALLOCATIONS_AT_MOST(1, list_int.push_back(1));
+    ASSERT_ALLOCATIONS_AT_MOST(1, list_int.insert(list_int.begin(), 0));
+    ASSERT_ALLOCATIONS_AT_MOST(0, for (int i : list_int) { (void)i; });
+    ASSERT_ALLOCATIONS_AT_MOST(0, list_int.pop_back());
+    ASSERT_ALLOCATIONS_AT_MOST(0, list_int.clear());
 }
 
 TEST_MAIN()
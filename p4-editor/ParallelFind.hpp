@@ -0,0 +1,163 @@
+#ifndef PARALLEL_FIND_HPP
+#define PARALLEL_FIND_HPP
+/* ParallelFind.hpp
+ *
+ * search of a large text split into chunks that are scanned in
+ * parallel by a work-stealing pool of threads
+ */
+
+#include <algorithm>  // std::max, std::min
+#include <atomic>
+#include <cstddef>  // std::size_t
+#include <cstdint>  // std::uint64_t
+#include <thread>
+#include <vector>
+
+class WorkStealingRanges {
+    // OVERVIEW: the indices [0, count) of some tasks, split into one
+    //           contiguous range per worker. Each worker takes tasks
+    //           from the front of its own range, and once that is empty
+    //           steals them from the back of the others'. A range is a
+    //           single atomic word, so taking and stealing are lock-free.
+   public:
+    // REQUIRES: workers > 0, count < 2^32
+    WorkStealingRanges(std::size_t count, unsigned workers) : ranges(workers) {
+        for (unsigned i = 0; i < workers; ++i) {
+            ranges[i].bounds = pack(count * i / workers, count * (i + 1) / workers);
+        }
+    }
+
+    // MODIFIES: *this
+    // EFFECTS:  Claims the next task for the given worker, returning
+    //           false if there are none left in any range.
+    bool next(unsigned worker, std::size_t &task) {
+        if (take(ranges[worker].bounds, true, task)) {
+            return true;
+        }
+        for (std::size_t i = 1; i < ranges.size(); ++i) {
+            if (take(ranges[(worker + i) % ranges.size()].bounds, false, task)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+   private:
+    struct alignas(64) Range {  // one per cache line, to avoid false sharing
+        std::atomic<std::uint64_t> bounds;  // begin in the high half, end in the low
+    };
+
+    std::vector<Range> ranges;
+
+    static std::uint64_t pack(std::uint64_t begin, std::uint64_t end) {
+        return begin << 32 | end;
+    }
+
+    // MODIFIES: bounds, task
+    // EFFECTS:  Takes a task from the front or back of the given range,
+    //           returning false if it is empty.
+    static bool take(std::atomic<std::uint64_t> &bounds, bool front, std::size_t &task) {
+        std::uint64_t old_bounds = bounds;
+        while (true) {
+            std::uint64_t begin = old_bounds >> 32;
+            std::uint64_t end = old_bounds & 0xFFFFFFFF;
+            if (begin >= end) {
+                return false;
+            }
+            std::uint64_t new_bounds = (front ? pack(begin + 1, end) : pack(begin, end - 1));
+            if (bounds.compare_exchange_weak(old_bounds, new_bounds)) {
+                task = (front ? begin : end - 1);
+                return true;
+            }
+        }
+    }
+};
+
+// The result of a parallel find.
+struct FindResult {
+    static constexpr std::size_t npos = -1;
+
+    std::size_t match = npos;  // offset of the match found, or npos if none
+    std::size_t number = 0;    // position of that match among all of them, from 1
+    std::size_t total = 0;     // number of matches in the whole text
+    bool wrapped = false;      // whether the match is before the start
+};
+
+constexpr std::size_t DEFAULT_FIND_CHUNK_SIZE = 1 << 20;  // bytes per task
+
+// REQUIRES: find(begin, end) returns the offset of the first match that
+//           starts in [begin, end), or FindResult::npos if there is none,
+//           reading past end as needed to complete a match; it can be
+//           called from several threads at once
+// EFFECTS:  Splits [0, size) into chunks and finds and counts the
+//           matches in each one in parallel, on the given number of
+//           threads, or one per core if threads is zero. Returns the
+//           first match that starts at or after start, or if there is
+//           none, the first match in the text (wrapping around). If
+//           canceled is set during the search, the result is partial.
+template <typename Find>
+FindResult parallel_find(std::size_t size, std::size_t start, Find find, unsigned threads = 0,
+                         std::size_t chunk_size = DEFAULT_FIND_CHUNK_SIZE,
+                         const std::atomic<bool> *canceled = nullptr) {
+    struct ChunkResult {
+        std::size_t first = FindResult::npos;        // first match in the chunk
+        std::size_t first_after = FindResult::npos;  // first at or after start
+        std::size_t before = 0;                      // matches before start
+        std::size_t count = 0;
+    };
+    std::size_t chunks = std::max<std::size_t>(1, (size + chunk_size - 1) / chunk_size);
+    std::vector<ChunkResult> results(chunks);  // each is written by one thread only
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = std::min<std::size_t>(threads, chunks);
+    WorkStealingRanges ranges(chunks, threads);
+
+    auto work = [&](unsigned worker) {
+        for (std::size_t i; !(canceled && *canceled) && ranges.next(worker, i);) {
+            ChunkResult &result = results[i];
+            std::size_t end = std::min(size, (i + 1) * chunk_size);
+            for (std::size_t match = find(i * chunk_size, end); match != FindResult::npos;
+                 match = find(match + 1, end)) {
+                if (result.count++ == 0) {
+                    result.first = match;
+                }
+                if (match < start) {
+                    ++result.before;
+                } else if (result.first_after == FindResult::npos) {
+                    result.first_after = match;
+                }
+            }
+        }
+    };
+    std::vector<std::thread> workers;
+    for (unsigned i = 1; i < threads; ++i) {
+        workers.emplace_back(work, i);
+    }
+    work(0);  // the calling thread is one of the workers
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+
+    FindResult found;
+    std::size_t before = 0;
+    for (const ChunkResult &result : results) {
+        found.total += result.count;
+        before += result.before;
+        if (found.match == FindResult::npos && result.first_after != FindResult::npos) {
+            found.match = result.first_after;
+        }
+    }
+    if (found.match != FindResult::npos) {
+        found.number = before + 1;
+    } else if (found.total > 0) {
+        for (std::size_t i = 0; found.match == FindResult::npos; ++i) {
+            found.match = results[i].first;
+        }
+        found.number = 1;
+        found.wrapped = true;
+    }
+    return found;
+}
+
+#endif
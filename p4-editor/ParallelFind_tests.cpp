@@ -0,0 +1,149 @@
+#include "ParallelFind.hpp"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "unit_test_framework.hpp"
+
+using namespace std;
+
+// Helpers
+FindResult find_in(const string &text, const string &pattern, size_t start, unsigned threads,
+                   size_t chunk_size);
+FindResult find_sequentially(const string &text, const string &pattern, size_t start);
+void assert_same(const FindResult &actual, const FindResult &expected);
+
+TEST(test_ranges_run_each_task_once) {
+    const size_t TASKS = 1000;
+    const unsigned WORKERS = 4;
+    WorkStealingRanges ranges(TASKS, WORKERS);
+    vector<atomic<int>> runs(TASKS);
+    vector<thread> workers;
+    for (unsigned worker = 0; worker < WORKERS; ++worker) {
+        workers.emplace_back([&, worker]() {
+            size_t task;
+            while (ranges.next(worker, task)) {
+                ++runs[task];
+            }
+        });
+    }
+    for (thread &worker : workers) {
+        worker.join();
+    }
+    for (atomic<int> &count : runs) {
+        ASSERT_EQUAL(count, 1);
+    }
+}
+
+TEST(test_ranges_steal) {
+    WorkStealingRanges ranges(4, 2);  // worker 0 has [0, 2), worker 1 has [2, 4)
+    size_t task;
+    ASSERT_TRUE(ranges.next(1, task));
+    ASSERT_EQUAL(task, 2u);
+    ASSERT_TRUE(ranges.next(1, task));
+    ASSERT_EQUAL(task, 3u);
+    ASSERT_TRUE(ranges.next(1, task));  // stolen from the back of worker 0's
+    ASSERT_EQUAL(task, 1u);
+    ASSERT_TRUE(ranges.next(0, task));
+    ASSERT_EQUAL(task, 0u);
+    ASSERT_FALSE(ranges.next(0, task));
+    ASSERT_FALSE(ranges.next(1, task));
+}
+
+TEST(test_find_after_start) {
+    string text = "abc abc abc";
+    FindResult result = find_in(text, "abc", 1, 2, 3);
+    ASSERT_EQUAL(result.match, 4u);
+    ASSERT_EQUAL(result.number, 2u);
+    ASSERT_EQUAL(result.total, 3u);
+    ASSERT_FALSE(result.wrapped);
+    result = find_in(text, "abc", 4, 2, 3);
+    ASSERT_EQUAL(result.match, 4u);
+    ASSERT_EQUAL(result.number, 2u);
+}
+
+TEST(test_find_wraps) {
+    FindResult result = find_in("xyz..xyz..", "xyz", 6, 3, 2);
+    ASSERT_EQUAL(result.match, 0u);
+    ASSERT_EQUAL(result.number, 1u);
+    ASSERT_EQUAL(result.total, 2u);
+    ASSERT_TRUE(result.wrapped);
+}
+
+TEST(test_find_none) {
+    FindResult result = find_in("aaaa", "b", 0, 2, 1);
+    ASSERT_EQUAL(result.match, FindResult::npos);
+    ASSERT_EQUAL(result.total, 0u);
+    result = find_in("", "b", 0, 2, 1);
+    ASSERT_EQUAL(result.match, FindResult::npos);
+}
+
+TEST(test_find_across_chunks) {
+    // every chunk size splits some matches, which are still found once
+    string text;
+    for (int i = 0; i < 500; ++i) {
+        text += (i % 7 == 0 ? "needle" : i % 3 == 0 ? "needl" : "hay");
+    }
+    text += "aaaaa";  // overlapping matches of "aa"
+    for (size_t chunk_size : {1, 2, 5, 6, 7, 64, 1000, 100000}) {
+        for (unsigned threads : {1, 3, 8}) {
+            for (size_t start : {size_t(0), size_t(777), text.size() - 3, text.size()}) {
+                assert_same(find_in(text, "needle", start, threads, chunk_size),
+                            find_sequentially(text, "needle", start));
+                assert_same(find_in(text, "aa", start, threads, chunk_size),
+                            find_sequentially(text, "aa", start));
+            }
+        }
+    }
+}
+
+TEST(test_find_canceled) {
+    string text(10000, 'a');
+    atomic<bool> canceled(true);
+    FindResult result = parallel_find(
+        text.size(), 0,
+        [&](size_t from, size_t to) { return from < to ? from : FindResult::npos; }, 4, 100,
+        &canceled);
+    ASSERT_EQUAL(result.total, 0u);
+}
+
+// Finds pattern in text with parallel_find.
+FindResult find_in(const string &text, const string &pattern, size_t start, unsigned threads,
+                   size_t chunk_size) {
+    return parallel_find(
+        text.size(), start,
+        [&](size_t from, size_t to) {
+            size_t found = text.find(pattern, from);
+            return found < to ? found : FindResult::npos;
+        },
+        threads, chunk_size);
+}
+
+// Finds pattern in text one match at a time.
+FindResult find_sequentially(const string &text, const string &pattern, size_t start) {
+    FindResult result;
+    for (size_t found = text.find(pattern); found != string::npos;
+         found = text.find(pattern, found + 1)) {
+        ++result.total;
+        if (result.match == FindResult::npos && found >= start) {
+            result.match = found;
+            result.number = result.total;
+        }
+    }
+    if (result.match == FindResult::npos && result.total > 0) {
+        result.match = text.find(pattern);
+        result.number = 1;
+        result.wrapped = true;
+    }
+    return result;
+}
+
+void assert_same(const FindResult &actual, const FindResult &expected) {
+    ASSERT_EQUAL(actual.match, expected.match);
+    ASSERT_EQUAL(actual.number, expected.number);
+    ASSERT_EQUAL(actual.total, expected.total);
+    ASSERT_EQUAL(actual.wrapped, expected.wrapped);
+}
+
+TEST_MAIN()
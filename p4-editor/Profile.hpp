@@ -0,0 +1,201 @@
+#ifndef PROFILE_HPP
+#define PROFILE_HPP
+/* Profile.hpp
+ *
+ * lightweight scoped timers and event counters, which are compiled in
+ * only when FEMTO_PROFILE is defined
+ */
+
+#include <algorithm>  // std::max
+#include <atomic>
+#include <chrono>
+#include <cstdio>   // std::snprintf, std::fopen
+#include <cstring>  // std::strcmp
+#include <deque>
+#include <string>
+#include <vector>
+
+class Profile {
+    // OVERVIEW: a registry of named statistics, each of which is either
+    //           a timer that adds up the time spent in a scope or a
+    //           counter of events. The run is divided into samples (such
+    //           as the handling of one keystroke), and each statistic
+    //           records its total over the run, its value in the last
+    //           complete sample, and its largest value in any sample.
+    //           Statistics are registered on their first use by the
+    //           PROFILE_* macros, which expand to nothing unless
+    //           FEMTO_PROFILE is defined. Only the allocation count may
+    //           be updated from more than one thread.
+   public:
+#ifdef FEMTO_PROFILE
+    static constexpr bool ENABLED = true;
+#else
+    static constexpr bool ENABLED = false;
+#endif
+
+    enum Kind { TIMER, COUNTER };
+
+    struct Stat {
+        const char *name;
+        Kind kind;
+        long calls = 0;      // number of times the timer ran or the counter was updated
+        double total = 0;    // milliseconds for a timer, events for a counter
+        double current = 0;  // in the current sample
+        double last = 0;     // in the last complete sample
+        double max = 0;      // in the largest complete sample
+
+        // MODIFIES: *this
+        // EFFECTS:  Adds the given amount to the current sample.
+        void add(double amount) {
+            ++calls;
+            total += amount;
+            current += amount;
+        }
+    };
+
+    // Measures the time from its creation to its destruction.
+    class ScopedTimer {
+       public:
+        explicit ScopedTimer(Stat &stat_in) : stat(stat_in), start(clock::now()) {}
+
+        ScopedTimer(const ScopedTimer &) = delete;
+        ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+        ~ScopedTimer() {
+            stat.add(std::chrono::duration<double, std::milli>(clock::now() - start).count());
+        }
+
+       private:
+        using clock = std::chrono::steady_clock;
+        Stat &stat;
+        clock::time_point start;
+    };
+
+    // Number of calls to operator new, if it is replaced with one that
+    // counts them.
+    static inline std::atomic<long> allocations{0};
+
+    // EFFECTS: Returns the statistic with the given name, registering
+    //          it with the given kind if there is none.
+    static Stat &stat(const char *name, Kind kind) {
+        for (Stat &existing : registry()) {
+            if (std::strcmp(existing.name, name) == 0) {
+                return existing;
+            }
+        }
+        registry().push_back(Stat{name, kind});
+        return registry().back();
+    }
+
+    // EFFECTS: Returns every registered statistic, in the order they
+    //          were registered.
+    static const std::deque<Stat> &stats() {
+        return registry();
+    }
+
+    // EFFECTS: Returns the number of complete samples.
+    static long samples() {
+        return sample_count();
+    }
+
+    // MODIFIES: every statistic
+    // EFFECTS:  Ends the current sample and starts a new one. The
+    //           allocations since the last sample are recorded in the
+    //           "allocations" counter.
+    static void end_sample() {
+        if (long allocated = allocations.exchange(0)) {
+            stat("allocations", COUNTER).add(allocated);
+        }
+        for (Stat &stat : registry()) {
+            stat.last = stat.current;
+            stat.max = std::max(stat.max, stat.current);
+            stat.current = 0;
+        }
+        ++sample_count();
+    }
+
+    // MODIFIES: every statistic
+    // EFFECTS:  Discards all recorded values, keeping the statistics
+    //           registered.
+    static void reset() {
+        allocations = 0;
+        for (Stat &stat : registry()) {
+            stat = Stat{stat.name, stat.kind};
+        }
+        sample_count() = 0;
+    }
+
+    // EFFECTS: Returns a table of the statistics, one line per
+    //          statistic after a heading. Times are in milliseconds.
+    static std::vector<std::string> report() {
+        std::vector<std::string> lines;
+        char line[128];
+        std::string heading = std::to_string(samples()) + " samples";
+        std::snprintf(line, sizeof(line), "%-18s %9s %9s %9s %11s", heading.c_str(), "last",
+                      "max", "avg", "total");
+        lines.push_back(line);
+        double count = std::max(1L, samples());
+        for (const Stat &stat : registry()) {
+            const char *format = (stat.kind == TIMER ? "%-18.18s %9.3f %9.3f %9.3f %11.3f"
+                                                     : "%-18.18s %9.0f %9.0f %9.1f %11.0f");
+            std::snprintf(line, sizeof(line), format, stat.name, stat.last, stat.max,
+                          stat.total / count, stat.total);
+            lines.push_back(line);
+        }
+        return lines;
+    }
+
+    // EFFECTS: Writes the report to the given file. Returns whether or
+    //          not it succeeded.
+    static bool write(const std::string &filename) {
+        std::FILE *file = std::fopen(filename.c_str(), "w");
+        if (!file) {
+            return false;
+        }
+        for (const std::string &line : report()) {
+            std::fprintf(file, "%s\n", line.c_str());
+        }
+        return std::fclose(file) == 0;
+    }
+
+   private:
+    // a deque, so that registering a statistic does not move the others
+    static std::deque<Stat> &registry() {
+        static std::deque<Stat> all;
+        return all;
+    }
+
+    static long &sample_count() {
+        static long count = 0;
+        return count;
+    }
+};
+
+#ifdef FEMTO_PROFILE
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+// Times the rest of the enclosing scope.
+#define PROFILE_SCOPE(name)                                                          \
+    static Profile::Stat &PROFILE_CONCAT(profile_stat_, __LINE__) =                  \
+        Profile::stat(name, Profile::TIMER);                                         \
+    Profile::ScopedTimer PROFILE_CONCAT(profile_timer_, __LINE__)(                   \
+        PROFILE_CONCAT(profile_stat_, __LINE__))
+// Adds the given amount to a counter.
+#define PROFILE_COUNT(name, amount)                                                  \
+    do {                                                                             \
+        static Profile::Stat &profile_stat = Profile::stat(name, Profile::COUNTER); \
+        profile_stat.add(amount);                                                    \
+    } while (false)
+// Ends the current sample.
+#define PROFILE_SAMPLE() Profile::end_sample()
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_COUNT(name, amount) \
+    do {                            \
+    } while (false)
+#define PROFILE_SAMPLE() \
+    do {                 \
+    } while (false)
+#endif
+
+#endif
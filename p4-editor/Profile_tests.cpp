@@ -0,0 +1,84 @@
+#define FEMTO_PROFILE
+#include "Profile.hpp"
+
+#include <thread>
+
+#include "unit_test_framework.hpp"
+
+using namespace std;
+
+// Helpers
+void count_twice(int amount);
+
+TEST(test_register_once) {
+    Profile::reset();
+    Profile::Stat &stat = Profile::stat("test register", Profile::COUNTER);
+    ASSERT_EQUAL(&Profile::stat("test register", Profile::COUNTER), &stat);
+    ASSERT_EQUAL(stat.kind, Profile::COUNTER);
+    ASSERT_EQUAL(stat.calls, 0);
+}
+
+TEST(test_counter_samples) {
+    Profile::reset();
+    long samples = Profile::samples();
+    count_twice(3);
+    Profile::Stat &stat = Profile::stat("test counter", Profile::COUNTER);
+    ASSERT_EQUAL(stat.current, 6);
+    ASSERT_EQUAL(stat.last, 0);
+    PROFILE_SAMPLE();
+    count_twice(1);
+    PROFILE_SAMPLE();
+    ASSERT_EQUAL(Profile::samples(), samples + 2);
+    ASSERT_EQUAL(stat.calls, 4);
+    ASSERT_EQUAL(stat.total, 8);
+    ASSERT_EQUAL(stat.last, 2);
+    ASSERT_EQUAL(stat.max, 6);
+    ASSERT_EQUAL(stat.current, 0);
+}
+
+TEST(test_scope_timer) {
+    Profile::reset();
+    for (int i = 0; i < 2; ++i) {
+        PROFILE_SCOPE("test timer");
+        this_thread::sleep_for(chrono::milliseconds(5));
+    }
+    PROFILE_SAMPLE();
+    Profile::Stat &stat = Profile::stat("test timer", Profile::TIMER);
+    ASSERT_EQUAL(stat.kind, Profile::TIMER);
+    ASSERT_EQUAL(stat.calls, 2);
+    ASSERT_TRUE(stat.total >= 10);
+    ASSERT_EQUAL(stat.last, stat.total);
+}
+
+TEST(test_allocations) {
+    Profile::reset();
+    Profile::allocations += 5;
+    PROFILE_SAMPLE();
+    ASSERT_EQUAL(Profile::stat("allocations", Profile::COUNTER).last, 5);
+    ASSERT_EQUAL(Profile::allocations, 0);
+}
+
+TEST(test_report) {
+    Profile::reset();
+    count_twice(2);
+    PROFILE_SAMPLE();
+    vector<string> lines = Profile::report();
+    ASSERT_EQUAL(lines.size(), Profile::stats().size() + 1);
+    ASSERT_EQUAL(lines[0].find("1 samples"), 0u);
+    bool found = false;
+    for (const string &line : lines) {
+        if (line.find("test counter") == 0) {
+            found = true;
+            ASSERT_NOT_EQUAL(line.find(" 4 "), string::npos);
+        }
+    }
+    ASSERT_TRUE(found);
+}
+
+void count_twice(int amount) {
+    for (int i = 0; i < 2; ++i) {
+        PROFILE_COUNT("test counter", amount);
+    }
+}
+
+TEST_MAIN()
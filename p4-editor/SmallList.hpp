@@ -0,0 +1,161 @@
+#ifndef SMALL_LIST_HPP
+#define SMALL_LIST_HPP
+/* SmallList.hpp
+ *
+ * List that keeps its first few nodes inside the list object itself,
+ * so that short lists need no heap allocations
+ */
+
+#include <cstddef>  // std::size_t
+#include <memory>   // std::allocator
+
+#include "List.hpp"
+
+template <typename T, int N>
+class InlineNodes {
+    // OVERVIEW: storage for N nodes of a List<T>, each either in use or
+    //           free.
+   public:
+    static_assert(0 < N && N <= 32, "InlineNodes holds between 1 and 32 nodes");
+
+    // the layout of a List node
+    struct NodeShape {
+        void *next;
+        void *prev;
+        T datum;
+    };
+
+    InlineNodes() : used(0) {}
+
+    // disable copying, as the nodes are linked to each other
+    InlineNodes(const InlineNodes &) = delete;
+    InlineNodes &operator=(const InlineNodes &) = delete;
+
+    // MODIFIES: *this
+    // EFFECTS:  Returns storage for a free node, now in use, or nullptr
+    //           if every node is in use.
+    void *take() {
+        for (int i = 0; i < N; ++i) {
+            if (!(used & 1u << i)) {
+                used |= 1u << i;
+                return slots[i].bytes;
+            }
+        }
+        return nullptr;
+    }
+
+    // MODIFIES: *this
+    // EFFECTS:  Frees the given node and returns true if it is one of
+    //           these, and otherwise returns false.
+    bool give_back(void *node) {
+        for (int i = 0; i < N; ++i) {
+            if (node == slots[i].bytes) {
+                used &= ~(1u << i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+   private:
+    struct Slot {
+        alignas(NodeShape) unsigned char bytes[sizeof(NodeShape)];
+    };
+
+    Slot slots[N];
+    unsigned used;  // bit i is set if slots[i] is in use
+};
+
+template <typename U, typename Nodes>
+class InlineAllocator {
+    // OVERVIEW: an allocator that places single nodes in the given
+    //           InlineNodes while it has free ones, and everything else
+    //           on the heap. Copies, including rebound ones, share the
+    //           nodes, except that a copy made for a container's copy
+    //           constructor allocates only on the heap, since the copied
+    //           container may outlive the nodes.
+   public:
+    using value_type = U;
+
+    // EFFECTS: Creates an allocator that uses the given nodes, or only
+    //          the heap if there are none.
+    explicit InlineAllocator(Nodes *nodes_in = nullptr) : nodes(nodes_in) {}
+
+    template <typename V>
+    InlineAllocator(const InlineAllocator<V, Nodes> &other) : nodes(other.nodes) {}
+
+    U *allocate(std::size_t n) {
+        if (n == 1 && nodes) {
+            static_assert(sizeof(U) <= sizeof(typename Nodes::NodeShape) &&
+                              alignof(U) <= alignof(typename Nodes::NodeShape),
+                          "InlineAllocator only allocates List nodes inline");
+            if (void *node = nodes->take()) {
+                return static_cast<U *>(node);
+            }
+        }
+        return std::allocator<U>().allocate(n);
+    }
+
+    void deallocate(U *memory, std::size_t n) {
+        if (!(n == 1 && nodes && nodes->give_back(memory))) {
+            std::allocator<U>().deallocate(memory, n);
+        }
+    }
+
+    InlineAllocator select_on_container_copy_construction() const {
+        return InlineAllocator();
+    }
+
+    template <typename V>
+    bool operator==(const InlineAllocator<V, Nodes> &other) const {
+        return nodes == other.nodes;
+    }
+
+    template <typename V>
+    bool operator!=(const InlineAllocator<V, Nodes> &other) const {
+        return nodes != other.nodes;
+    }
+
+   private:
+    template <typename, typename>
+    friend class InlineAllocator;
+
+    Nodes *nodes;  // or nullptr to use only the heap
+};
+
+template <typename T, int N = 4>
+class SmallList : private InlineNodes<T, N>,
+                  public List<T, InlineAllocator<T, InlineNodes<T, N>>> {
+    // OVERVIEW: a List whose first N nodes are stored inside the list
+    //           object, so that a list of up to N elements makes no heap
+    //           allocations. Further nodes are allocated on the heap, and
+    //           erasing any node frees its storage for the next one
+    //           inserted. It has the interface and iterators of List. As
+    //           its nodes may be inside it, a SmallList cannot be moved
+    //           other than by copying.
+   public:
+    using Allocator = InlineAllocator<T, InlineNodes<T, N>>;
+
+    SmallList() : List<T, Allocator>(Allocator(this)) {}
+
+    SmallList(const SmallList &other) : SmallList() {
+        for (const T &datum : other) {
+            this->push_back(datum);
+        }
+    }
+
+    // EFFECTS: Replaces the elements with copies of those of other. If
+    //          copying one throws, the list is left with those copied
+    //          before it.
+    SmallList &operator=(const SmallList &other) {
+        if (this != &other) {
+            this->clear();
+            for (const T &datum : other) {
+                this->push_back(datum);
+            }
+        }
+        return *this;
+    }
+};
+
+#endif
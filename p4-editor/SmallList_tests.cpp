@@ -0,0 +1,82 @@
+#include "SmallList.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#define UNIT_TEST_COUNT_ALLOCATIONS 1
+#include "unit_test_framework.hpp"
+
+using namespace std;
+
+// Helpers
+template <typename List>
+vector<typename List::value_type> contents(const List &list);
+
+TEST(test_small_lists_do_not_allocate) {
+    SmallList<int, 3> list_int;
+    ASSERT_ALLOCATIONS_AT_MOST(0, list_int.push_back(1); list_int.push_front(0));
+    ASSERT_ALLOCATIONS_AT_MOST(0, list_int.insert(list_int.end(), 2));
+    ASSERT_ALLOCATIONS_AT_MOST(1, list_int.push_back(3));  // spills to the heap
+    ASSERT_TRUE(contents(list_int) == vector<int>({0, 1, 2, 3}));
+    list_int.erase(list_int.begin());
+    ASSERT_ALLOCATIONS_AT_MOST(0, list_int.push_back(4));  // reuses the inline node
+    ASSERT_TRUE(contents(list_int) == vector<int>({1, 2, 3, 4}));
+    list_int.clear();
+    ASSERT_ALLOCATIONS_AT_MOST(0, list_int.push_back(5); list_int.push_back(6));
+    ASSERT_TRUE(contents(list_int) == vector<int>({5, 6}));
+}
+
+TEST(test_iterators) {
+    SmallList<int, 2> list_int;
+    for (int i = 0; i < 5; ++i) {
+        list_int.push_back(i);
+    }
+    SmallList<int, 2>::Iterator last = list_int.end();
+    ASSERT_EQUAL(*--last, 4);
+    ASSERT_TRUE(equal(list_int.rbegin(), list_int.rend(), contents(list_int).rbegin()));
+    SmallList<int, 2>::ConstIterator found = find(list_int.cbegin(), list_int.cend(), 3);
+    ASSERT_EQUAL(distance(list_int.cbegin(), found), 3);
+    list_int.erase(list_int.begin());
+    ASSERT_EQUAL(*list_int.begin(), 1);
+    ASSERT_EQUAL(list_int.size(), 4);
+}
+
+TEST(test_copy) {
+    SmallList<string> copied;
+    {
+        SmallList<string> list_str;
+        list_str.push_back("hello");
+        list_str.push_back("world");
+        SmallList<string> list_copy(list_str);
+        list_copy.front() = "goodbye";
+        ASSERT_EQUAL(list_str.front(), "hello");
+        copied = list_copy;
+    }  // the copy has its own nodes
+    ASSERT_TRUE(contents(copied) == vector<string>({"goodbye", "world"}));
+    copied = copied;
+    ASSERT_EQUAL(copied.size(), 2);
+}
+
+TEST(test_copy_as_list) {
+    using Base = List<int, SmallList<int>::Allocator>;
+    Base *list_copy;
+    {
+        SmallList<int> list_int;
+        list_int.push_back(1);
+        list_int.push_back(2);
+        list_copy = new Base(list_int);  // allocates on the heap
+    }
+    list_copy->push_back(3);
+    ASSERT_TRUE(contents(*list_copy) == vector<int>({1, 2, 3}));
+    delete list_copy;
+}
+
+// Returns the elements of the given list in order.
+template <typename List>
+vector<typename List::value_type> contents(const List &list) {
+    return vector<typename List::value_type>(list.begin(), list.end());
+}
+
+TEST_MAIN()
@@ -0,0 +1,355 @@
+#ifndef SNAPSHOT_HPP
+#define SNAPSHOT_HPP
+/* Snapshot.hpp
+ *
+ * immutable, versioned snapshots of a text, published by the thread
+ * that edits it and read by other threads without locks
+ */
+
+#include <algorithm>  // std::min, std::upper_bound
+#include <array>
+#include <atomic>
+#include <cstddef>  // std::size_t
+#include <cstdint>  // std::uint64_t
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>  // std::this_thread::yield
+#include <utility>  // std::pair
+#include <vector>
+
+class Snapshot {
+    // OVERVIEW: an immutable copy of a text at some version. The text is
+    //           held in chunks that are shared with the snapshots
+    //           published before and after it, so that publishing after
+    //           a small edit copies one chunk and the list of chunks
+    //           rather than the whole text.
+   public:
+    using Chunk = std::shared_ptr<const std::string>;
+
+    static constexpr std::size_t npos = -1;
+
+    // EFFECTS: Returns the version of the text, which increases each
+    //          time a changed text is published.
+    std::uint64_t version() const {
+        return version_number;
+    }
+
+    // EFFECTS: Returns the number of bytes in the text.
+    std::size_t size() const {
+        return length;
+    }
+
+    // EFFECTS: Returns up to count bytes of the text starting at the
+    //          given offset, stopping at the end of the text.
+    std::string copy(std::size_t offset, std::size_t count) const {
+        std::string text;
+        for (std::size_t i = chunk_containing(offset); i < chunks.size() && count > 0; ++i) {
+            std::size_t start = (offset > starts[i] ? offset - starts[i] : 0);
+            std::size_t taken = std::min(count, chunks[i]->size() - start);
+            text.append(*chunks[i], start, taken);
+            count -= taken;
+        }
+        return text;
+    }
+
+    // REQUIRES: pattern is not empty
+    // EFFECTS:  Returns the offset of the first occurrence of pattern
+    //           that starts in [from, to), or npos if there is none.
+    //           Stops early, returning npos, once canceled is set.
+    std::size_t find(const std::string &pattern, std::size_t from, std::size_t to = npos,
+                     const std::atomic<bool> *canceled = nullptr) const {
+        to = std::min(to, length);
+        for (std::size_t i = chunk_containing(from); i < chunks.size() && starts[i] < to; ++i) {
+            if (canceled && *canceled) {
+                return npos;
+            }
+            const std::string &text = *chunks[i];
+            std::size_t start = (from > starts[i] ? from - starts[i] : 0);
+            std::size_t found = text.find(pattern, start);
+            if (found == std::string::npos && text.size() > start) {
+                // look for one that continues into the following chunks
+                std::size_t tail = std::max(start, text.size() - std::min(text.size(),
+                                                                          pattern.size() - 1));
+                std::string window =
+                    text.substr(tail) + copy(starts[i] + text.size(), pattern.size() - 1);
+                found = window.find(pattern);
+                found += (found == std::string::npos ? 0 : tail);
+            }
+            if (found != std::string::npos) {
+                return starts[i] + found < to ? starts[i] + found : npos;
+            }
+        }
+        return npos;
+    }
+
+   private:
+    friend class SnapshotPublisher;
+
+    std::uint64_t version_number;
+    std::vector<Chunk> chunks;        // none are empty
+    std::vector<std::size_t> starts;  // offset of the first byte of each chunk
+    std::size_t length;
+
+    // EFFECTS: Returns the index of the chunk containing the given
+    //          offset, or the number of chunks if it is past the end.
+    std::size_t chunk_containing(std::size_t offset) const {
+        if (offset >= length) {
+            return chunks.size();
+        }
+        return std::upper_bound(starts.begin(), starts.end(), offset) - starts.begin() - 1;
+    }
+};
+
+class SnapshotPublisher {
+    // OVERVIEW: the text of an editor as seen by other threads. The
+    //           thread that edits the text applies each edit here and
+    //           publishes a new Snapshot when other threads need one.
+    //           Readers pin the latest snapshot without locks, and a
+    //           replaced snapshot is deleted once no reader that might
+    //           have pinned it remains (epoch-based reclamation). Every
+    //           member function but those of Reader must be called on
+    //           the editing thread.
+   public:
+    static const std::size_t CHUNK_SIZE = 4096;  // bytes per chunk, when split
+    static const int MAX_READERS = 16;           // readers that can pin at once
+
+    class Reader {
+        // OVERVIEW: pins the latest published snapshot, which stays
+        //           valid until the reader is destroyed. Waits for a
+        //           free slot if MAX_READERS readers are already pinned.
+       public:
+        explicit Reader(const SnapshotPublisher &publisher_in) : publisher(publisher_in) {
+            for (slot = 0;; slot = (slot + 1) % MAX_READERS) {
+                std::uint64_t free = 0;
+                if (publisher.reader_epochs[slot].compare_exchange_strong(free,
+                                                                          publisher.epoch)) {
+                    break;
+                } else if (slot == MAX_READERS - 1) {
+                    std::this_thread::yield();
+                }
+            }
+            snapshot = publisher.current;  // after announcing the epoch
+        }
+
+        Reader(const Reader &) = delete;
+        Reader &operator=(const Reader &) = delete;
+
+        ~Reader() {
+            publisher.reader_epochs[slot] = 0;
+        }
+
+        const Snapshot &operator*() const {
+            return *snapshot;
+        }
+
+        const Snapshot *operator->() const {
+            return snapshot;
+        }
+
+       private:
+        const SnapshotPublisher &publisher;
+        int slot;
+        const Snapshot *snapshot;
+    };
+
+    // EFFECTS: Creates a publisher of the given text, and publishes it
+    //          as version 1.
+    explicit SnapshotPublisher(std::string_view text = "") : edited(true), epoch(1) {
+        for (auto &reader_epoch : reader_epochs) {
+            reader_epoch = 0;
+        }
+        current = nullptr;
+        insert(0, text);
+        publish();
+    }
+
+    SnapshotPublisher(const SnapshotPublisher &) = delete;
+    SnapshotPublisher &operator=(const SnapshotPublisher &) = delete;
+
+    // REQUIRES: no Reader of this publisher remains
+    ~SnapshotPublisher() {
+        delete current.load();
+        for (auto &retired_snapshot : retired) {
+            delete retired_snapshot.second;
+        }
+    }
+
+    // EFFECTS: Returns the version of the latest published snapshot.
+    std::uint64_t version() const {
+        return current.load()->version_number;
+    }
+
+    // EFFECTS: Returns whether the text has been edited since the latest
+    //          snapshot was published.
+    bool dirty() const {
+        return edited;
+    }
+
+    // REQUIRES: offset <= size of the text
+    // MODIFIES: *this
+    // EFFECTS:  Inserts the given text at the given offset. Only the
+    //           chunk containing the offset is copied.
+    void insert(std::size_t offset, std::string_view text) {
+        if (text.empty()) {
+            return;
+        }
+        edited = true;
+        std::size_t i = locate(offset);
+        if (i == chunks.size()) {
+            chunks.push_back(std::make_shared<const std::string>());
+        }
+        std::string changed = *chunks[i];
+        changed.insert(offset, text);
+        replace(i, std::move(changed));
+    }
+
+    // REQUIRES: offset + count <= size of the text
+    // MODIFIES: *this
+    // EFFECTS:  Erases count bytes starting at the given offset. Only the
+    //           chunks at either end of them are copied, and the whole
+    //           chunks between are removed at once.
+    void erase(std::size_t offset, std::size_t count) {
+        if (count == 0) {
+            return;
+        }
+        edited = true;
+        std::size_t first = locate(offset);
+        std::size_t i = first;
+        if (offset > 0 || count < chunks[i]->size()) {  // part of the first chunk
+            std::size_t taken = std::min(count, chunks[i]->size() - offset);
+            std::string changed = *chunks[i];
+            changed.erase(offset, taken);
+            chunks[i++] = std::make_shared<const std::string>(std::move(changed));
+            count -= taken;
+        }
+        std::size_t whole = i;
+        for (; whole < chunks.size() && count >= chunks[whole]->size(); ++whole) {
+            count -= chunks[whole]->size();
+        }
+        chunks.erase(chunks.begin() + i, chunks.begin() + whole);
+        if (count > 0) {  // part of the last chunk
+            std::string changed = *chunks[i];
+            changed.erase(0, count);
+            chunks[i] = std::make_shared<const std::string>(std::move(changed));
+        }
+        resized(first);
+    }
+
+    // MODIFIES: *this
+    // EFFECTS:  Publishes the text as a new snapshot, if it has been
+    //           edited since the last one, and deletes the snapshots
+    //           that readers can no longer see.
+    void publish() {
+        if (edited) {
+            Snapshot *snapshot = new Snapshot;
+            const Snapshot *previous = current;
+            snapshot->version_number = (previous ? previous->version_number + 1 : 1);
+            snapshot->chunks = chunks;
+            update_starts(chunks.size());
+            snapshot->starts = starts;
+            snapshot->length = (chunks.empty() ? 0 : starts.back() + chunks.back()->size());
+            current.exchange(snapshot);
+            if (previous) {
+                // readers that announce a later epoch will see the new snapshot
+                retired.push_back({epoch++, previous});
+            }
+            edited = false;
+        }
+        reclaim();
+    }
+
+   private:
+    std::vector<Snapshot::Chunk> chunks;  // the text as edited, none empty
+    std::vector<std::size_t> starts;      // offset of the first byte of each chunk
+    std::size_t known_starts = 0;         // number of starts that are up to date
+    bool edited;                          // whether chunks differs from current
+    std::atomic<const Snapshot *> current;
+    std::atomic<std::uint64_t> epoch;
+    mutable std::array<std::atomic<std::uint64_t>, MAX_READERS> reader_epochs;  // 0 if free
+    std::vector<std::pair<std::uint64_t, const Snapshot *>> retired;  // with their epochs
+    // INVARIANT: a retired snapshot is only deleted once no reader has
+    //            announced an epoch at or before the one it was retired in
+
+    // REQUIRES: offset <= size of the text
+    // MODIFIES: offset, *this
+    // EFFECTS:  Returns the index of the chunk containing the given
+    //           offset, which is made relative to the chunk. An offset
+    //           at the end of the text is in the last chunk, if any.
+    //           The chunk is found by binary search, after bringing the
+    //           starts up to date as far as the offset.
+    std::size_t locate(std::size_t &offset) {
+        if (chunks.empty()) {
+            return 0;
+        }
+        while (known_starts < chunks.size() &&
+               (known_starts == 0 ||
+                starts[known_starts - 1] + chunks[known_starts - 1]->size() <= offset)) {
+            update_starts(known_starts + 1);
+        }
+        std::size_t i =
+            std::upper_bound(starts.begin(), starts.begin() + known_starts, offset) -
+            starts.begin() - 1;
+        offset -= starts[i];
+        return i;
+    }
+
+    // REQUIRES: count <= number of chunks
+    // MODIFIES: *this
+    // EFFECTS:  Brings the starts of the first count chunks up to date.
+    void update_starts(std::size_t count) {
+        starts.resize(chunks.size());
+        for (; known_starts < count; ++known_starts) {
+            std::size_t i = known_starts;
+            starts[i] = (i == 0 ? 0 : starts[i - 1] + chunks[i - 1]->size());
+        }
+    }
+
+    // MODIFIES: *this
+    // EFFECTS:  Records that chunk i has changed size, or that chunks
+    //           were added or removed there, so the starts of the chunks
+    //           after it are out of date. Its own start is unchanged.
+    void resized(std::size_t i) {
+        known_starts = std::min({known_starts, i + 1, chunks.size()});
+    }
+
+    // MODIFIES: *this
+    // EFFECTS:  Replaces chunk i with the given text, split into chunks
+    //           of CHUNK_SIZE bytes if it is more than twice as long.
+    void replace(std::size_t i, std::string text) {
+        resized(i);
+        if (text.size() <= 2 * CHUNK_SIZE) {
+            chunks[i] = std::make_shared<const std::string>(std::move(text));
+            return;
+        }
+        std::vector<Snapshot::Chunk> pieces;
+        for (std::size_t start = 0; start < text.size(); start += CHUNK_SIZE) {
+            pieces.push_back(std::make_shared<const std::string>(text.substr(start, CHUNK_SIZE)));
+        }
+        chunks.erase(chunks.begin() + i);
+        chunks.insert(chunks.begin() + i, pieces.begin(), pieces.end());
+    }
+
+    // MODIFIES: *this
+    // EFFECTS:  Deletes the retired snapshots that no reader can see.
+    void reclaim() {
+        std::uint64_t oldest = epoch;  // the oldest epoch a reader announced
+        for (const auto &reader_epoch : reader_epochs) {
+            std::uint64_t announced = reader_epoch;
+            if (announced != 0) {
+                oldest = std::min(oldest, announced);
+            }
+        }
+        auto kept = retired.begin();
+        for (auto &retired_snapshot : retired) {
+            if (retired_snapshot.first < oldest) {
+                delete retired_snapshot.second;
+            } else {
+                *kept++ = retired_snapshot;
+            }
+        }
+        retired.erase(kept, retired.end());
+    }
+};
+
+#endif
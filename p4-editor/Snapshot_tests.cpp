@@ -0,0 +1,148 @@
+#include "Snapshot.hpp"
+
+#include <thread>
+#include <vector>
+
+#include "unit_test_framework.hpp"
+
+using namespace std;
+
+// Helpers
+string text_of_version(uint64_t version);
+
+TEST(test_publish_versions) {
+    SnapshotPublisher publisher("hello");
+    ASSERT_EQUAL(publisher.version(), 1u);
+    ASSERT_FALSE(publisher.dirty());
+    publisher.publish();  // nothing changed
+    ASSERT_EQUAL(publisher.version(), 1u);
+    publisher.insert(5, " world");
+    ASSERT_TRUE(publisher.dirty());
+    ASSERT_EQUAL(publisher.version(), 1u);
+    publisher.publish();
+    ASSERT_EQUAL(publisher.version(), 2u);
+    SnapshotPublisher::Reader snapshot(publisher);
+    ASSERT_EQUAL(snapshot->copy(0, 100), "hello world");
+    ASSERT_EQUAL(snapshot->size(), 11u);
+}
+
+TEST(test_reader_keeps_snapshot) {
+    SnapshotPublisher publisher("abc");
+    SnapshotPublisher::Reader old_snapshot(publisher);
+    publisher.erase(0, 1);
+    publisher.insert(2, "d");
+    publisher.publish();
+    publisher.publish();  // would delete the old snapshot if it were unpinned
+    SnapshotPublisher::Reader new_snapshot(publisher);
+    ASSERT_EQUAL(old_snapshot->version(), 1u);
+    ASSERT_EQUAL(old_snapshot->copy(0, 10), "abc");
+    ASSERT_EQUAL(new_snapshot->version(), 2u);
+    ASSERT_EQUAL(new_snapshot->copy(0, 10), "bcd");
+}
+
+TEST(test_edits_across_chunks) {
+    const size_t CHUNK = SnapshotPublisher::CHUNK_SIZE;
+    string text;
+    for (size_t i = 0; i < 5 * CHUNK; ++i) {
+        text.push_back('a' + i % 26);
+    }
+    SnapshotPublisher publisher(text);
+    publisher.erase(CHUNK - 10, CHUNK + 20);  // spans three chunks
+    text.erase(CHUNK - 10, CHUNK + 20);
+    publisher.insert(2 * CHUNK, "xyz");
+    text.insert(2 * CHUNK, "xyz");
+    publisher.erase(0, CHUNK - 10);  // the rest of the first chunk
+    text.erase(0, CHUNK - 10);
+    publisher.insert(text.size(), "end");
+    text += "end";
+    publisher.publish();
+    SnapshotPublisher::Reader snapshot(publisher);
+    ASSERT_EQUAL(snapshot->size(), text.size());
+    ASSERT_TRUE(snapshot->copy(0, text.size()) == text);
+    ASSERT_EQUAL(snapshot->copy(CHUNK - 2, 4), text.substr(CHUNK - 2, 4));
+}
+
+TEST(test_random_edits) {
+    const size_t CHUNK = SnapshotPublisher::CHUNK_SIZE;
+    string text(20 * CHUNK, '.');
+    SnapshotPublisher publisher(text);
+    unsigned state = 1;
+    for (int i = 0; i < 300; ++i) {
+        state = state * 1103515245 + 12345;
+        size_t offset = (state >> 4) % (text.size() + 1);
+        if (i % 2 == 0) {  // erases of up to several whole chunks
+            size_t count = min(text.size() - offset, size_t(state >> 12) % (3 * CHUNK));
+            publisher.erase(offset, count);
+            text.erase(offset, count);
+        } else {
+            string inserted((state >> 12) % (3 * CHUNK), 'a' + i % 26);
+            publisher.insert(offset, inserted);
+            text.insert(offset, inserted);
+        }
+        if (i % 7 == 0) {  // publishing brings every chunk's offset up to date
+            publisher.publish();
+        }
+    }
+    publisher.publish();
+    SnapshotPublisher::Reader snapshot(publisher);
+    ASSERT_EQUAL(snapshot->size(), text.size());
+    ASSERT_TRUE(snapshot->copy(0, text.size()) == text);
+}
+
+TEST(test_find) {
+    const size_t CHUNK = SnapshotPublisher::CHUNK_SIZE;
+    string text(3 * CHUNK, '.');
+    text.replace(CHUNK - 2, 5, "match");  // across a chunk boundary
+    text.replace(2 * CHUNK + 7, 5, "match");
+    SnapshotPublisher publisher(text);
+    SnapshotPublisher::Reader snapshot(publisher);
+    ASSERT_EQUAL(snapshot->find("match", 0), CHUNK - 2);
+    ASSERT_EQUAL(snapshot->find("match", CHUNK - 1), 2 * CHUNK + 7);
+    ASSERT_EQUAL(snapshot->find("match", CHUNK - 1, 2 * CHUNK + 7), Snapshot::npos);
+    ASSERT_EQUAL(snapshot->find("match", 0, CHUNK - 1), CHUNK - 2);
+    ASSERT_EQUAL(snapshot->find("none", 0), Snapshot::npos);
+    ASSERT_EQUAL(snapshot->find("match", text.size()), Snapshot::npos);
+    atomic<bool> canceled(true);
+    ASSERT_EQUAL(snapshot->find("match", 0, Snapshot::npos, &canceled), Snapshot::npos);
+}
+
+TEST(test_concurrent_readers) {
+    // readers check that each snapshot they pin is consistent while the
+    // writer keeps editing and publishing
+    SnapshotPublisher publisher(text_of_version(1));
+    atomic<bool> stopping(false);
+    atomic<int> inconsistent(0);
+    vector<thread> readers;
+    for (int i = 0; i < 4; ++i) {
+        readers.emplace_back([&]() {
+            uint64_t last_version = 0;
+            while (!stopping) {
+                SnapshotPublisher::Reader snapshot(publisher);
+                if (snapshot->version() < last_version ||
+                    snapshot->copy(0, snapshot->size()) != text_of_version(snapshot->version())) {
+                    ++inconsistent;
+                }
+                last_version = snapshot->version();
+            }
+        });
+    }
+    for (uint64_t version = 2; version <= 2000; ++version) {
+        string previous = text_of_version(version - 1);
+        publisher.erase(0, previous.size());
+        publisher.insert(0, text_of_version(version));
+        publisher.publish();
+    }
+    stopping = true;
+    for (thread &reader : readers) {
+        reader.join();
+    }
+    ASSERT_EQUAL(inconsistent, 0);
+    ASSERT_EQUAL(publisher.version(), 2000u);
+}
+
+// Returns the text the concurrent test publishes at each version.
+string text_of_version(uint64_t version) {
+    return string(version % 300 * 37, char('a' + version % 26)) + to_string(version);
+}
+
+TEST_MAIN()
@@ -0,0 +1,149 @@
+#ifndef WRAP_LAYOUT_HPP
+#define WRAP_LAYOUT_HPP
+/* WrapLayout.hpp
+ *
+ * cache of where the rows of a text wrap onto visual lines
+ */
+
+#include <algorithm>  // std::lower_bound, std::upper_bound, std::min
+#include <cassert>
+#include <cstddef>  // std::size_t
+#include <vector>
+
+class WrapLayout {
+    // OVERVIEW: records, for each row of a text, the column that starts
+    //           each visual line the row wraps onto. Rows are laid out
+    //           lazily, one visual line at a time, so a row may be known
+    //           only up to some line. The visual line of a column is
+    //           found by binary search, so moving between the visual
+    //           lines of a long row takes O(log n) time rather than a
+    //           scan of the row. An edit keeps the lines of its row that
+    //           start before the edited column, and shifts the rows
+    //           after it.
+   public:
+    // EFFECTS: Creates an empty layout for the given window width.
+    explicit WrapLayout(int width_in = 0) : line_width(width_in) {}
+
+    // EFFECTS: Returns the width that rows are wrapped to.
+    int width() const {
+        return line_width;
+    }
+
+    // MODIFIES: *this
+    // EFFECTS:  Discards the layout of every row, and wraps rows to the
+    //           given width from now on.
+    void reset(int width_in) {
+        line_width = width_in;
+        rows.clear();
+    }
+
+    // MODIFIES: *this
+    // EFFECTS:  Records an edit that starts at the given row and column,
+    //           and removes and inserts the given numbers of newlines.
+    void edit(int row, int column, int removed_rows, int inserted_rows) {
+        std::size_t first = row - 1;  // index of the edited row
+        if (first >= rows.size()) {
+            return;  // not laid out
+        }
+        // lines that start before the edit are not affected by it
+        std::vector<int> &starts = rows[first].starts;
+        starts.erase(std::lower_bound(starts.begin(), starts.end(), column), starts.end());
+        rows[first].complete = false;
+        auto after = rows.begin() + first + 1;
+        rows.erase(after, after + std::min<std::size_t>(removed_rows, rows.end() - after));
+        rows.insert(rows.begin() + first + 1, inserted_rows, Row());
+    }
+
+    // EFFECTS: Returns whether the whole row has been laid out.
+    bool is_complete(int row) const {
+        return row <= static_cast<int>(rows.size()) && rows[row - 1].complete;
+    }
+
+    // EFFECTS: Returns whether the visual line of the row containing the
+    //          given column is known, along with where it ends.
+    bool covers(int row, int column) const {
+        return is_complete(row) || last_start(row) > column;
+    }
+
+    // EFFECTS: Returns the number of visual lines of the row that are
+    //          known, which is all of them if it is complete.
+    int known_lines(int row) const {
+        return row <= static_cast<int>(rows.size()) ? std::max<int>(rows[row - 1].starts.size(), 1)
+                                                     : 1;
+    }
+
+    // EFFECTS: Returns the first column of the last known visual line of
+    //          the row.
+    int last_start(int row) const {
+        return line_start(row, known_lines(row) - 1);
+    }
+
+    // REQUIRES: 0 <= line < known_lines(row)
+    // EFFECTS:  Returns the first column of the given visual line of the
+    //           row.
+    int line_start(int row, int line) const {
+        return line == 0 ? 0 : rows[row - 1].starts[line];
+    }
+
+    // REQUIRES: covers(row, column)
+    // EFFECTS:  Returns the visual line of the row that contains the
+    //           given column.
+    int line_containing(int row, int column) const {
+        if (row > static_cast<int>(rows.size()) || rows[row - 1].starts.empty()) {
+            return 0;
+        }
+        const std::vector<int> &starts = rows[row - 1].starts;
+        return std::upper_bound(starts.begin(), starts.end(), column) - starts.begin() - 1;
+    }
+
+    // REQUIRES: is_complete(row)
+    // EFFECTS:  Returns the number of visual lines in the row.
+    int line_count(int row) const {
+        assert(is_complete(row));
+        return known_lines(row);
+    }
+
+    // REQUIRES: !is_complete(row) and column > last_start(row)
+    // MODIFIES: *this
+    // EFFECTS:  Records that the next visual line of the row starts at
+    //           the given column.
+    void add_line(int row, int column) {
+        assert(!is_complete(row) && column > last_start(row));
+        starts_of(row).push_back(column);
+    }
+
+    // MODIFIES: *this
+    // EFFECTS:  Records that the last known visual line of the row ends
+    //           the row.
+    void complete_row(int row) {
+        starts_of(row);
+        rows[row - 1].complete = true;
+    }
+
+   private:
+    struct Row {
+        std::vector<int> starts;  // first column of each visual line
+        bool complete = false;    // whether starts has every line
+    };
+
+    int line_width;
+    std::vector<Row> rows;  // from row 1
+    // INVARIANT: rows[i].starts is empty if row i + 1 has not been laid
+    //            out at all, and otherwise starts with 0
+
+    // MODIFIES: *this
+    // EFFECTS:  Returns the line starts of the row, adding the row if
+    //           needed.
+    std::vector<int> &starts_of(int row) {
+        if (row > static_cast<int>(rows.size())) {
+            rows.resize(row);
+        }
+        std::vector<int> &starts = rows[row - 1].starts;
+        if (starts.empty()) {
+            starts.push_back(0);
+        }
+        return starts;
+    }
+};
+
+#endif
@@ -0,0 +1,76 @@
+#include "WrapLayout.hpp"
+
+#include "unit_test_framework.hpp"
+
+using namespace std;
+
+// Helpers
+void lay_out(WrapLayout &layout, int row, int length);
+
+TEST(test_unknown_row) {
+    WrapLayout layout(10);
+    ASSERT_FALSE(layout.is_complete(3));
+    ASSERT_FALSE(layout.covers(3, 0));
+    ASSERT_EQUAL(layout.known_lines(3), 1);
+    ASSERT_EQUAL(layout.last_start(3), 0);
+    ASSERT_EQUAL(layout.line_containing(3, 0), 0);
+}
+
+TEST(test_lines) {
+    WrapLayout layout(10);
+    lay_out(layout, 2, 25);
+    ASSERT_TRUE(layout.is_complete(2));
+    ASSERT_EQUAL(layout.line_count(2), 3);
+    ASSERT_EQUAL(layout.line_start(2, 1), 10);
+    ASSERT_EQUAL(layout.line_containing(2, 0), 0);
+    ASSERT_EQUAL(layout.line_containing(2, 19), 1);
+    ASSERT_EQUAL(layout.line_containing(2, 25), 2);
+    ASSERT_FALSE(layout.is_complete(1));
+}
+
+TEST(test_partial_row) {
+    WrapLayout layout(10);
+    layout.add_line(1, 10);
+    ASSERT_TRUE(layout.covers(1, 9));
+    ASSERT_FALSE(layout.covers(1, 10));
+    ASSERT_EQUAL(layout.known_lines(1), 2);
+    layout.complete_row(1);
+    ASSERT_TRUE(layout.covers(1, 100));
+}
+
+TEST(test_edit_keeps_earlier_lines) {
+    WrapLayout layout(10);
+    lay_out(layout, 1, 35);
+    layout.edit(1, 15, 0, 0);
+    ASSERT_FALSE(layout.is_complete(1));
+    ASSERT_EQUAL(layout.known_lines(1), 2);  // lines starting at 0 and 10
+    ASSERT_TRUE(layout.covers(1, 9));
+    ASSERT_FALSE(layout.covers(1, 15));
+}
+
+TEST(test_edit_shifts_rows) {
+    WrapLayout layout(10);
+    lay_out(layout, 1, 5);
+    lay_out(layout, 2, 15);
+    lay_out(layout, 3, 25);
+
+    layout.edit(1, 5, 0, 2);  // two new rows after row 1
+    ASSERT_FALSE(layout.is_complete(1));
+    ASSERT_FALSE(layout.covers(2, 0));
+    ASSERT_FALSE(layout.covers(3, 0));
+    ASSERT_EQUAL(layout.line_count(4), 2);
+    ASSERT_EQUAL(layout.line_count(5), 3);
+
+    layout.edit(3, 0, 2, 0);  // join rows 3 to 5
+    ASSERT_FALSE(layout.covers(3, 0));
+    ASSERT_FALSE(layout.covers(4, 0));
+}
+
+void lay_out(WrapLayout &layout, int row, int length) {
+    for (int start = layout.width(); start < length; start += layout.width()) {
+        layout.add_line(row, start);
+    }
+    layout.complete_row(row);
+}
+
+TEST_MAIN()
@@ -11,20 +11,72 @@
 #include <ncurses.h>
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <clocale>  // std::setlocale
+#include <cmath>    // std::ceil
+#include <cstdint>  // std::uint64_t
 #include <cstdio>
+#include <cstdlib>  // std::malloc, std::free
 #include <cstring>
+#include <cwchar>  // std::mbrtowc, wcwidth
 #include <fstream>
+#include <functional>  // std::boyer_moore_horspool_searcher
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <new>  // std::bad_alloc
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
 
+#include "BufferStore.hpp"
 #include "Editor.hpp"
+#include "FileView.hpp"
+#include "Highlighter.hpp"
+#include "LineIndex.hpp"
+#include "ParallelFind.hpp"
+#include "Profile.hpp"
+#include "Snapshot.hpp"
+#include "WrapLayout.hpp"
 
 #ifndef FEMTO_INPUT_MODE  // default to terminal input mode
 #define FEMTO_INPUT_MODE TERMINAL
 #endif
 
+#ifndef FEMTO_MAX_FPS  // default limit on screen redraws per second
+#define FEMTO_MAX_FPS 60
+#endif
+
+#ifndef FEMTO_BUFFER_BUDGET  // bytes of memory for the text of inactive buffers
+#define FEMTO_BUFFER_BUDGET (64 << 20)
+#endif
+
+#ifndef FEMTO_PROFILE_FILE  // where profile statistics are written on exit
+#define FEMTO_PROFILE_FILE "femto_profile.txt"
+#endif
+
+#ifdef FEMTO_PROFILE
+// Count allocations for the profile.
+void *operator new(std::size_t size) {
+    ++Profile::allocations;
+    if (void *memory = std::malloc(size > 0 ? size : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void *memory, std::size_t) noexcept {
+    std::free(memory);
+}
+#endif
+
 class FemtoEditor {
    public:
     static constexpr const char *version = "2.80";
@@ -34,19 +86,57 @@ class FemtoEditor {
         RAW        // control keys are passed uninterpreted to FEMTO
     };
 
-    // Initialize the editor with the given file and input mode.
-    // Starts the interaction.
-    FemtoEditor(std::string filename_in, InputMode input_mode_in)
+    // Initialize the editor with the given files, each opened in its own
+    // buffer with the first one shown, and input mode. If view_only is
+    // true, the first file is paged in read-only from disk rather than
+    // loaded into the editor. The screen is redrawn at most max_fps
+    // times a second, or after every input if it is 0. Starts the
+    // interaction.
+    FemtoEditor(const std::vector<std::string> &filenames, InputMode input_mode_in,
+                bool view_only = false, double max_fps_in = FEMTO_MAX_FPS)
         : baseline(1),
           cursor_row(1),
-          filename(filename_in),
+          filename(filenames.empty() ? "" : filenames[0]),
           modified(false),
           percentage(0),
           status("initial"),
-          input_mode(input_mode_in) {
-        if (!filename.empty()) {
+          input_mode(input_mode_in),
+          max_fps(max_fps_in) {
+        // keep a copy of the text that worker threads can read, and the
+        // mark on the character it was set at
+        editbuffer.editor.set_change_callback(
+            [this](int index, int removed_bytes, std::string_view inserted) {
+                snapshots.erase(index, removed_bytes);
+                snapshots.insert(index, inserted);
+                edited_bytes += removed_bytes + inserted.size();
+                checkpoints_complete = false;
+                if (selection.active) {
+                    move_mark(index, removed_bytes, inserted.size());
+                }
+            });
+        if (view_only) {
+            viewer = std::make_unique<Viewer>(filename);
+            status = "read-only";
+        } else if (!filename.empty()) {
             read_file();
         }
+        edited_bytes = 0;  // a loaded text is already in order
+        buffers.push_back({filename, false, status, buffer_store.add(""), 0, 1, 1, 0});
+        for (std::size_t i = 1; i < filenames.size() && !view_only; ++i) {
+            if (find_buffer(filenames[i]) == buffers.size()) {
+                add_buffer(filenames[i]);
+            }
+        }
+        if (!view_only && Highlighter::supports(filename)) {
+            highlighter = std::make_unique<Highlighter>();
+        }
+        editbuffer.editor.set_edit_callback(
+            [this](int row, int column, int removed_rows, int inserted_rows) {
+                if (highlighter) {
+                    highlighter->edit(row, removed_rows, inserted_rows);
+                }
+                layout.edit(row, column, removed_rows, inserted_rows);
+            });
         setup_windows();
         interact();
     }
@@ -59,11 +149,25 @@ class FemtoEditor {
     ~FemtoEditor() {
         curs_set(visibility);  // restore prior visibility
         endwin();
+        std::printf("\033[?2004l");  // disable bracketed paste
+        std::fflush(stdout);
+        count_editor_steps();  // in the last sample
+        if (Profile::ENABLED && !Profile::write(FEMTO_PROFILE_FILE)) {
+            std::cerr << "Unable to write profile to " << FEMTO_PROFILE_FILE << std::endl;
+        }
     }
 
    private:
     using clock_t = std::chrono::steady_clock;
-    static constexpr double MESSAGE_TIMEOUT = 5;  // time in seconds
+    static constexpr double MESSAGE_TIMEOUT = 5;   // time in seconds
+    static const int INDEXING_REFRESH = 250;       // time in milliseconds
+    static const int SEARCH_POLL = 5;              // time in milliseconds
+    static constexpr int COMPACT_IDLE = 1000;      // time in milliseconds
+    static constexpr int COMPACT_FRACTION = 16;    // compact after edits to 1/16 of the text
+    static constexpr int INDEX_IDLE = 250;         // time in milliseconds
+    static constexpr int PASTE_TIMEOUT = 500;      // time in milliseconds
+    static constexpr int CHECKPOINT_SLICE = 1 << 20;  // bytes walked per idle step
+    static constexpr double MAX_BATCH_TIME = 100;  // time in milliseconds
     static const std::size_t MAX_SHORT_STRING_LENGTH = 20;
 
     struct KeyBindings {
@@ -78,6 +182,14 @@ class FemtoEditor {
         static const int GOTO = 7;       // ^G
         static const int CUT = 11;       // ^K
         static const int UNCUT = 21;     // ^U
+        static const int COPY = 5;       // ^E
+        static const int MARK = 30;      // ^^ (^6) - pico/nano binding
+        static const int BLOCK = 18;     // ^R
+        static const int WRAP = 2;       // ^B
+        static const int FRAME_STATS = 20;  // ^T
+        static const int PROFILE = 25;      // ^Y
+        static const int OPEN = 16;         // ^P
+        static const int NEXT_BUFFER = 29;  // ^]
         static const int CANCEL = 14;    // ^N
         static const int INTERRUPT = 3;  // ^C
         static const int ESCAPE = 27;
@@ -96,8 +208,11 @@ class FemtoEditor {
         static const int PAGE_UP = 567;      // ^up on Windows
         static const int IGNORE1 = -1;       // sent when mucking with the window
         static const int IGNORE2 = 410;      // sent when mucking with the window
+        static const int PASTE_BEGIN = 1024;  // defined for "\033[200~" (bracketed paste)
+        static const int PASTE_END = 1025;    // defined for "\033[201~" (bracketed paste)
         static const int MIN_CHAR = 1;
         static const int MAX_CHAR = 126;
+        static const int MAX_BYTE = 255;  // bytes of UTF-8 encoded characters
 
         static constexpr bool is_exit(int c) {
             return c == EXIT1 || c == EXIT2 || c == INTERRUPT;
@@ -120,6 +235,30 @@ class FemtoEditor {
         static constexpr bool is_uncut(int c) {
             return c == UNCUT;
         }
+        static constexpr bool is_copy(int c) {
+            return c == COPY;
+        }
+        static constexpr bool is_wrap(int c) {
+            return c == WRAP;
+        }
+        static constexpr bool is_frame_stats(int c) {
+            return c == FRAME_STATS;
+        }
+        static constexpr bool is_profile(int c) {
+            return c == PROFILE;
+        }
+        static constexpr bool is_open(int c) {
+            return c == OPEN;
+        }
+        static constexpr bool is_next_buffer(int c) {
+            return c == NEXT_BUFFER;
+        }
+        static constexpr bool is_mark(int c) {
+            return c == MARK;
+        }
+        static constexpr bool is_block(int c) {
+            return c == BLOCK;
+        }
         static constexpr bool is_cancel(int c) {
             return c == CANCEL || c == INTERRUPT || c == ESCAPE;
         }
@@ -165,7 +304,10 @@ class FemtoEditor {
             return c == WORD_RIGHT1 || c == WORD_RIGHT2 || c == WORD_RIGHT3;
         }
         static constexpr bool is_ignore(int c) {
-            return c == IGNORE1 || c == IGNORE2;
+            return c == IGNORE1 || c == IGNORE2 || c == PASTE_END;
+        }
+        static constexpr bool is_paste(int c) {
+            return c == PASTE_BEGIN;
         }
     };
 
@@ -212,26 +354,33 @@ class FemtoEditor {
             int window_width = getmaxx(window) - prefix.size() - 1;
             // column in the window where current character will be written
             int window_column = (view_column != 0 ? 1 : 0);
+            // common case: the view column does not change
+            std::string visible = editor.copy_to_column(cursor_column + 1);
+            if (window_column + femto.display_width(window_column, visible) <= window_width) {
+                return;
+            }
             for (; editor.get_column() <= cursor_column &&
                    !editor.is_at_end()                 // handle end of buffer
                    && editor.get_row() == cursor_row;  // handle end of row
                  editor.forward()) {
-                char c = editor.data_at_cursor();
+                std::string c = editor.character_at_cursor();
                 window_column += femto.display_width(window_column, c);
-                if (window_column > window_width && c != '\n') {
+                if (window_column > window_width && c != "\n") {
                     // slide view column to the right
                     window_width = getmaxx(window) - prefix.size() - 1;
                     int remaining = window_width - 1;  // right overflow marker
                     // max of current char + 4 chars to the left of current
-                    for (int i = 0, ichar = editor.data_at_cursor();
-                         i < 5 && remaining - femto.display_width(0, ichar) >= 0;
-                         remaining -= femto.display_width(0, ichar), ++i, editor.backward(),
-                             ichar = editor.data_at_cursor())
-                        ;
+                    for (int i = 0; i < 5; ++i, editor.backward()) {
+                        int width = femto.display_width(0, editor.character_at_cursor());
+                        if (remaining - width < 0) {
+                            break;
+                        }
+                        remaining -= width;
+                    }
                     editor.forward();  // we went back too far by one character
                     view_column = editor.get_column();
                     // set window column after current character
-                    window_column = 1 + femto.display_width(1, editor.data_at_cursor());
+                    window_column = 1 + femto.display_width(1, editor.character_at_cursor());
                 }
             }
             if (editor.get_row() != cursor_row) {  // we moved to the next row
@@ -241,6 +390,121 @@ class FemtoEditor {
         }
     };
 
+    struct Selection {
+        bool active;       // whether the mark is set
+        bool rectangular;  // whether the selection is a column block
+        int mark_row;      // of mark_index, unless moved
+        int mark_column;   // of mark_index, unless moved
+        int mark_index;    // kept on the same character as the text is edited
+        bool moved;        // whether an edit before the mark has changed its row or column
+    };
+
+    // State of the read-only viewer for large files.
+    struct Viewer {
+        FileView file;
+        std::size_t top_line;      // line shown at the top of the canvas
+        std::size_t top_offset;    // offset of the start of top_line
+        std::size_t shift;         // characters scrolled off to the left
+        std::size_t match_offset;  // location of the last search match
+        std::size_t match_length;  // zero if there is no match
+
+        explicit Viewer(const std::string &filename)
+            : file(filename), top_line(1), top_offset(0), shift(0), match_offset(0),
+              match_length(0) {
+        }
+    };
+
+    // A search for a string from the cursor, run by worker threads on a
+    // snapshot of the text while the editor keeps handling input.
+    struct BackgroundSearch {
+        std::string search;
+        std::size_t start;  // index of the cursor when the search began
+        std::atomic<bool> done;
+        std::atomic<bool> canceled;
+        std::uint64_t version;  // of the snapshot searched, once done
+        FindResult result;      // once done
+        std::thread worker;
+
+        // Start searching the latest snapshot from the given publisher.
+        BackgroundSearch(const SnapshotPublisher &snapshots, const std::string &search_in,
+                         std::size_t start_in)
+            : search(search_in), start(start_in), done(false), canceled(false) {
+            worker = std::thread([this, &snapshots]() {
+                SnapshotPublisher::Reader snapshot(snapshots);
+                version = snapshot->version();
+                result = parallel_find(
+                    snapshot->size(), start + 1,  // skip the current character
+                    [&](std::size_t from, std::size_t to) {
+                        return find_characters(*snapshot, search, from, to, canceled);
+                    },
+                    0, DEFAULT_FIND_CHUNK_SIZE, &canceled);
+                done = true;
+            });
+        }
+
+        BackgroundSearch(const BackgroundSearch &) = delete;
+        BackgroundSearch &operator=(const BackgroundSearch &) = delete;
+
+        ~BackgroundSearch() {
+            canceled = true;
+            worker.join();
+        }
+    };
+
+    // A line index of a snapshot of the text, built by worker threads
+    // while the editor keeps handling input. LineIndex scans contiguous
+    // text, so the snapshot is first copied out of its chunks.
+    struct BackgroundIndex {
+        std::unique_ptr<SnapshotPublisher::Reader> snapshot;  // until copied
+        const std::uint64_t version;                          // of the snapshot indexed
+        std::string text;
+        std::unique_ptr<LineIndex> lines;  // once copied
+        std::atomic<bool> copied;
+        bool shown = false;  // whether the screen has been redrawn since it was done
+        std::thread worker;
+
+        // Start indexing the latest snapshot from the given publisher.
+        // It is pinned here, so that its version is known before the
+        // worker starts.
+        explicit BackgroundIndex(const SnapshotPublisher &snapshots)
+            : snapshot(std::make_unique<SnapshotPublisher::Reader>(snapshots)),
+              version((*snapshot)->version()),
+              copied(false) {
+            worker = std::thread([this]() {
+                text = (*snapshot)->copy(0, (*snapshot)->size());
+                snapshot.reset();  // let the publisher reclaim it
+                lines = std::make_unique<LineIndex>(text.data(), text.size());
+                copied = true;
+            });
+        }
+
+        BackgroundIndex(const BackgroundIndex &) = delete;
+        BackgroundIndex &operator=(const BackgroundIndex &) = delete;
+
+        // Stops indexing once the copy is done, since lines is destroyed
+        // before the text it scans.
+        ~BackgroundIndex() {
+            worker.join();
+        }
+
+        bool done() const {
+            return copied && lines->done();
+        }
+    };
+
+    // An open file. The text of the current one is in editbuffer, and
+    // that of the others in buffer_store, along with the state below.
+    struct OpenBuffer {
+        std::string filename;
+        bool modified;
+        std::string status;
+        int text_id;  // in buffer_store
+        int cursor_index;
+        int baseline;
+        int wrap_top_row;
+        int wrap_top_line;
+    };
+
     Buffer editbuffer = {{}, nullptr, false, "", "", 1, 0, '$', '$'};
     Buffer minibuffer = {{}, nullptr, true, "", "", 1, 0, '<', '>'};
     int baseline;  // row of top line in canvas
@@ -252,7 +516,26 @@ class FemtoEditor {
     std::string message;  // info/error message
     std::chrono::time_point<clock_t> message_time;
     std::string cut_value;
+    bool cut_rectangular = false;  // whether cut_value is a column block
+    bool cutting = false;          // whether the last input cut a line
+    Selection selection = {false, false, 1, 0, 0, false};
+    std::unique_ptr<Viewer> viewer;  // set in read-only viewer mode
+    std::unique_ptr<Highlighter> highlighter;  // set when editing C or C++ source
+    bool wrap = false;                         // whether long rows are soft wrapped
+    WrapLayout layout;                         // visual lines of rows when wrapped
+    int wrap_top_row = 1;                      // row shown at the top when wrapped
+    int wrap_top_line = 0;                     // visual line of that row shown
+    int color_attributes[Highlighter::NUM_COLORS];
     std::string previous_search;
+    SnapshotPublisher snapshots;  // the text of editbuffer, for worker threads
+    std::unique_ptr<BackgroundSearch> background_search;  // must be destroyed before snapshots
+    std::unique_ptr<BackgroundIndex> background_index;    // must be destroyed before snapshots
+    bool checkpoints_complete = false;  // whether seeks anywhere in editbuffer are short
+    BufferStore buffer_store{FEMTO_BUFFER_BUDGET};
+    std::vector<OpenBuffer> buffers;  // all open files, in the order opened
+    std::size_t current_buffer = 0;   // the one in editbuffer
+    std::size_t edited_bytes = 0;     // bytes changed since the text was last compacted
+    long counted_steps = 0;           // editbuffer steps already added to the profile
     WINDOW *main_window;
     WINDOW *canvas;
     WINDOW *top_bar;
@@ -260,8 +543,22 @@ class FemtoEditor {
     WINDOW *message_bar;
     WINDOW *bottom_bar;
     bool input_mode;
+    double max_fps;                        // limit on redraws per second, 0 for none
+    std::chrono::time_point<clock_t> last_frame;  // when the last frame was drawn
+    bool show_frame_stats = false;         // whether to show frame_stats in the overflow bar
+    bool show_profile = false;             // whether to show the Profile over the canvas
+    struct FrameStats {
+        long drawn = 0;
+        long dropped = 0;       // frames made obsolete by input before being drawn
+        double last_time = 0;   // time to render the last frame, in milliseconds
+        double total_time = 0;  // time to render all frames, in milliseconds
+    } frame_stats;
     int visibility;
     int char_widths[256];  // onscreen width of each character
+    // onscreen width of each code point in the Basic Multilingual Plane,
+    // filled in as they are displayed (UNKNOWN_WIDTH if not yet known)
+    signed char code_point_widths[0x10000];
+    static constexpr signed char UNKNOWN_WIDTH = -2;
 
     // Initial curses setup.
     // look the other way if you've ever programmed using curses
@@ -274,6 +571,11 @@ class FemtoEditor {
         }
         noecho();
         keypad(main_window, true);
+        // have the terminal mark the start and end of pasted text
+        define_key("\033[200~", KeyBindings::PASTE_BEGIN);
+        define_key("\033[201~", KeyBindings::PASTE_END);
+        std::printf("\033[?2004h");
+        std::fflush(stdout);
         visibility = curs_set(0);
 
         int ncols = getmaxx(main_window);
@@ -290,8 +592,10 @@ class FemtoEditor {
         message_bar = subwin(main_window, 1 /* lines */, ncols, nlines - 2, begx);
         bottom_bar = subwin(main_window, 1 /* lines */, ncols, nlines - 1, begx);
         editbuffer.window = canvas;
+        layout.reset(ncols - 1);  // leave room for the cursor after the last character
         minibuffer.window = bottom_bar;
         compute_character_widths();
+        setup_colors();
         render_all(highlight_canvas_cursor);  // render everything
     }
 
@@ -314,33 +618,253 @@ class FemtoEditor {
         // Special handling for backspace and delete
         char_widths[static_cast<unsigned char>('\b')] = 2;
         char_widths[static_cast<unsigned char>('\x7f')] = 2;
+        // code point widths depend on the locale, so look them up again
+        std::fill(std::begin(code_point_widths), std::end(code_point_widths), UNKNOWN_WIDTH);
     }
 
-    // Render all windows.
+    // Set up the colors used for syntax highlighting, if there is a
+    // highlighter and the terminal supports colors.
+    void setup_colors() {
+        std::fill(std::begin(color_attributes), std::end(color_attributes), A_NORMAL);
+        if (!highlighter || !has_colors()) {
+            return;
+        }
+        start_color();
+        use_default_colors();
+        static const short foregrounds[Highlighter::NUM_COLORS] = {
+            -1, COLOR_YELLOW, COLOR_CYAN, COLOR_GREEN, COLOR_MAGENTA, COLOR_BLUE};
+        for (int color = Highlighter::KEYWORD; color < Highlighter::NUM_COLORS; ++color) {
+            init_pair(color, foregrounds[color], -1 /* default background */);
+            color_attributes[color] = COLOR_PAIR(color);
+        }
+    }
+
+    // Render all windows, and send the changes to the terminal at once.
     void render_all(bool highlight_canvas_cursor = true) {
         render_canvas(highlight_canvas_cursor);
-        wrefresh(canvas);
+        if (show_profile) {
+            render_profile();
+        }
+        wnoutrefresh(canvas);
         render_top_bars();
-        wrefresh(top_bar);
-        wrefresh(overflow_bar);
+        wnoutrefresh(top_bar);
+        wnoutrefresh(overflow_bar);
         render_message_bar();
-        wrefresh(message_bar);
+        wnoutrefresh(message_bar);
         render_bottom_bar();
-        wrefresh(bottom_bar);
+        wnoutrefresh(bottom_bar);
+        PROFILE_SCOPE("doupdate");
+        doupdate();
+    }
+
+    // Render the profile statistics over the top right of the canvas.
+    void render_profile() {
+        std::vector<std::string> lines = Profile::report();
+        int x = getmaxx(canvas);
+        for (const std::string &line : lines) {
+            x = std::min<int>(x, getmaxx(canvas) - line.size() - 1);
+        }
+        x = std::max(0, x);
+        wattron(canvas, A_REVERSE);
+        for (int y = 0; y < static_cast<int>(lines.size()) && y < getmaxy(canvas); ++y) {
+            wmove(canvas, y, x);
+            wclrtoeol(canvas);
+            waddnstr(canvas, (" " + lines[y]).c_str(), getmaxx(canvas) - x);
+        }
+        wattroff(canvas, A_REVERSE);
     }
 
-    // Main interaction loop -- respond to user input.
+    // Main interaction loop -- respond to user input. Input is handled
+    // as soon as it arrives, but the screen is redrawn at most max_fps
+    // times a second, always showing the latest state. A frame that is
+    // made obsolete by more input before it is drawn is dropped. Once
+    // there has been no input for COMPACT_IDLE, the text is compacted if
+    // it has been edited enough. Once there has been none for INDEX_IDLE,
+    // the lines of the text are indexed in the background, and seeks
+    // are shortened in slices between checks for input.
     void interact() {
+        render_frame();
+        bool frame_pending = false;
+        auto last_input = clock_t::now();
+        while (true) {
+            int wait = (frame_pending ? time_until_next_frame() : -1);
+            if (viewer && !viewer->file.indexing_done() &&
+                (wait < 0 || wait > INDEXING_REFRESH)) {
+                wait = INDEXING_REFRESH;  // redraw indexing progress
+            }
+            if (background_search && (wait < 0 || wait > SEARCH_POLL)) {
+                wait = SEARCH_POLL;  // check for the search result
+            }
+            if (background_index && !background_index->shown &&
+                (wait < 0 || wait > INDEXING_REFRESH)) {
+                wait = INDEXING_REFRESH;  // check whether indexing is done
+            }
+            int idle = std::chrono::duration<double, std::milli>(clock_t::now() - last_input)
+                           .count();
+            if (compaction_due() && (wait < 0 || wait > COMPACT_IDLE - idle)) {
+                wait = std::max(0, COMPACT_IDLE - idle);
+            }
+            if (indexing_due() && (wait < 0 || wait > INDEX_IDLE - idle)) {
+                wait = std::max(0, INDEX_IDLE - idle);
+            }
+            int c = next_input(wait);
+            if (c != ERR) {
+                last_input = clock_t::now();
+                count_editor_steps();
+                PROFILE_SAMPLE();  // each input batch and the frames it causes is a sample
+                if (!handle_input_batch(c)) {
+                    return;
+                }
+                frame_stats.dropped += (frame_pending ? 1 : 0);
+                frame_pending = true;
+            } else if (viewer) {
+                frame_pending = true;
+            }
+            if (finish_search() || finish_indexing()) {
+                frame_pending = true;
+            }
+            if (frame_pending && time_until_next_frame() == 0) {
+                render_frame();
+                frame_pending = false;
+            }
+            if (c == ERR && compaction_due() &&
+                clock_t::now() - last_input >= std::chrono::milliseconds(COMPACT_IDLE)) {
+                PROFILE_SCOPE("Editor::compact");
+                editbuffer.editor.compact();
+                edited_bytes = 0;
+            }
+            if (c == ERR && indexing_due() &&
+                clock_t::now() - last_input >= std::chrono::milliseconds(INDEX_IDLE)) {
+                index_in_background();
+            }
+        }
+    }
+
+    // Return whether the lines of the text need indexing, or it has
+    // stretches that seeks would walk far through.
+    bool indexing_due() const {
+        return !viewer && (!checkpoints_complete || !background_index ||
+                           background_index->version != snapshots.version() || snapshots.dirty());
+    }
+
+    // Start indexing the lines of the text in a worker thread if they
+    // have changed since the last index, and add the checkpoints that
+    // seeks are missing in a slice that is short enough not to delay
+    // input noticeably.
+    void index_in_background() {
+        if (!background_index || background_index->version != snapshots.version() ||
+            snapshots.dirty()) {
+            background_index.reset();
+            snapshots.publish();
+            background_index = std::make_unique<BackgroundIndex>(snapshots);
+        }
+        if (!checkpoints_complete) {
+            PROFILE_SCOPE("extend_checkpoints");
+            checkpoints_complete = editbuffer.editor.extend_checkpoints(CHECKPOINT_SLICE);
+        }
+    }
+
+    // Return whether the background index has finished since the screen
+    // was last redrawn, so that the percentage can be shown by line.
+    bool finish_indexing() {
+        if (!background_index || background_index->shown || !background_index->done()) {
+            return false;
+        }
+        background_index->shown = true;
+        return true;
+    }
+
+    // Return the number of lines in the text if the background index of
+    // its latest version is done, or 0 if it is not.
+    std::size_t indexed_line_count() const {
+        if (!background_index || !background_index->done() || snapshots.dirty() ||
+            background_index->version != snapshots.version()) {
+            return 0;
+        }
+        return background_index->lines->line_count();
+    }
+
+    // Add the steps the cursor of the edit buffer has taken since this
+    // was last called to the profile, if they are counted.
+    void count_editor_steps() {
+#ifdef EDITOR_COUNT_STEPS
+        PROFILE_COUNT("editor steps", editbuffer.editor.step_count() - counted_steps);
+        counted_steps = editbuffer.editor.step_count();
+#endif
+    }
+
+    // Return whether enough of the text has been edited since it was
+    // last compacted that its nodes are likely scattered across the heap.
+    bool compaction_due() const {
+        return !viewer && edited_bytes > 0 &&
+               edited_bytes * COMPACT_FRACTION >= std::size_t(editbuffer.editor.size());
+    }
+
+    // Render all windows, recording how long it takes.
+    void render_frame() {
+        last_frame = clock_t::now();
+        render_all();
+        frame_stats.last_time =
+            std::chrono::duration<double, std::milli>(clock_t::now() - last_frame).count();
+        frame_stats.total_time += frame_stats.last_time;
+        ++frame_stats.drawn;
+    }
+
+    // Return the time in milliseconds until the next frame may be drawn.
+    int time_until_next_frame() const {
+        if (max_fps <= 0) {
+            return 0;
+        }
+        auto elapsed = std::chrono::duration<double, std::milli>(clock_t::now() - last_frame);
+        return std::max(0.0, std::ceil(1000 / max_fps - elapsed.count()));
+    }
+
+    // Handle the given input character, followed by any that are already
+    // waiting (such as the rest of a paste), so that the screen is redrawn
+    // once for the whole batch rather than once per character. Stops
+    // after MAX_BATCH_TIME to keep the screen updating during long
+    // pastes. Returns whether or not interaction should continue.
+    bool handle_input_batch(int c) {
+        auto start = clock_t::now();
         do {
-            render_all();
-        } while (handle_edit_input(getch()));
+            if (!handle_edit_input(c)) {
+                return false;
+            }
+        } while (std::chrono::duration<double, std::milli>(clock_t::now() - start).count() <
+                     MAX_BATCH_TIME &&
+                 (c = pending_input()) != ERR);
+        return true;
+    }
+
+    // Return the next input character if there is one waiting, or ERR
+    // if there is not.
+    int pending_input() {
+        timeout(0);
+        int c = getch();
+        timeout(-1);
+        return c;
+    }
+
+    // Wait up to the given number of milliseconds for the next input
+    // character, or indefinitely if it is negative. Returns ERR if there
+    // is none by then.
+    int next_input(int wait) {
+        timeout(wait);
+        int c = getch();
+        timeout(-1);
+        return c;
     }
 
     // Handle an input character in the edit buffer. Returns whether or
     // not interaction should continue.
     bool handle_edit_input(int c) {
+        PROFILE_SCOPE("handle_edit_input");
         clear_message();
-        if (KeyBindings::is_exit(c)) {
+        bool continuing_cut = cutting;
+        cutting = false;  // until another line is cut
+        if (viewer) {
+            return handle_view_input(c);
+        } else if (KeyBindings::is_exit(c)) {
             return !handle_exit();
         } else if (KeyBindings::is_save(c)) {
             set_modified(!handle_save(), true);
@@ -348,25 +872,153 @@ class FemtoEditor {
             handle_goto();
         } else if (KeyBindings::is_find(c)) {
             handle_find();
+        } else if (KeyBindings::is_open(c)) {
+            handle_open();
+        } else if (KeyBindings::is_next_buffer(c)) {
+            handle_next_buffer();
+        } else if (KeyBindings::is_mark(c)) {
+            handle_mark(false);
+        } else if (KeyBindings::is_block(c)) {
+            handle_mark(true);
+        } else if (KeyBindings::is_copy(c)) {
+            handle_copy();
+        } else if (KeyBindings::is_cut(c) && selection.active) {
+            take_selection(true);
         } else if (KeyBindings::is_cut(c)) {
-            return handle_cut();
+            handle_cut(continuing_cut);
         } else if (KeyBindings::is_uncut(c)) {
             handle_uncut();
+        } else if (KeyBindings::is_frame_stats(c)) {
+            show_frame_stats = !show_frame_stats;
+        } else if (KeyBindings::is_profile(c) && Profile::ENABLED) {
+            show_profile = !show_profile;
+        } else if (KeyBindings::is_profile(c)) {
+            set_message("Profiling is not enabled (build with PROFILE=1)", "No profile");
+        } else if (KeyBindings::is_wrap(c)) {
+            wrap = !wrap;
+            set_message(wrap ? "Soft wrap enabled" : "Soft wrap disabled",
+                        wrap ? "Wrap on" : "Wrap off");
+            wrap_top_row = editbuffer.editor.get_row();
+            wrap_top_line = 0;
+        } else if (KeyBindings::is_up(c) && wrap) {
+            move_visual_lines(-1);
         } else if (KeyBindings::is_up(c)) {
             editbuffer.editor.up();
+        } else if (KeyBindings::is_down(c) && wrap) {
+            move_visual_lines(1);
         } else if (KeyBindings::is_down(c)) {
             editbuffer.editor.down();
+        } else if (KeyBindings::is_pageup(c) && wrap) {
+            move_visual_lines(2 - getmaxy(canvas));
         } else if (KeyBindings::is_pageup(c)) {
             move_page(2 - getmaxy(canvas));
+        } else if (KeyBindings::is_pagedown(c) && wrap) {
+            move_visual_lines(getmaxy(canvas) - 2);
         } else if (KeyBindings::is_pagedown(c)) {
             move_page(getmaxy(canvas) - 2);
         } else {
             set_modified(
-                handle_buffer_input(editbuffer, c, KeyBindings::MIN_CHAR, KeyBindings::MAX_CHAR));
+                handle_buffer_input(editbuffer, c, KeyBindings::MIN_CHAR, KeyBindings::MAX_BYTE));
+        }
+        return true;
+    }
+
+    // Handle an input character in the read-only viewer. Returns whether
+    // or not interaction should continue.
+    bool handle_view_input(int c) {
+        if (KeyBindings::is_exit(c)) {
+            return false;
+        } else if (KeyBindings::is_goto(c)) {
+            handle_goto();
+        } else if (KeyBindings::is_find(c)) {
+            handle_find();
+        } else if (KeyBindings::is_up(c)) {
+            scroll_view(-1);
+        } else if (KeyBindings::is_down(c)) {
+            scroll_view(1);
+        } else if (KeyBindings::is_pageup(c)) {
+            scroll_view(2 - getmaxy(canvas));
+        } else if (KeyBindings::is_pagedown(c)) {
+            scroll_view(getmaxy(canvas) - 2);
+        } else if (KeyBindings::is_home(c)) {
+            view_line(1);
+        } else if (KeyBindings::is_end(c)) {
+            view_line(std::numeric_limits<std::size_t>::max());
+            scroll_view(1 - getmaxy(canvas));  // show the whole last page
+        } else if (KeyBindings::is_left(c)) {
+            viewer->shift -= (viewer->shift > 0 ? 1 : 0);
+        } else if (KeyBindings::is_right(c)) {
+            ++viewer->shift;
+        } else if (KeyBindings::is_refresh(c)) {
+            endwin();
+            setup_windows();
+        } else if (!KeyBindings::is_ignore(c)) {
+            set_message("File is read-only", "Read-only");
         }
         return true;
     }
 
+    // Scroll the viewer by the given number of lines.
+    void scroll_view(int offset) {
+        FileView &file = viewer->file;
+        for (; offset < 0 && viewer->top_line > 1; ++offset) {
+            viewer->top_offset = file.previous_line(viewer->top_offset);
+            --viewer->top_line;
+        }
+        for (; offset > 0; --offset) {
+            std::size_t end = file.line_end(viewer->top_offset);
+            if (end == file.size()) {
+                break;  // at the last line
+            }
+            viewer->top_offset = end + 1;
+            ++viewer->top_line;
+        }
+    }
+
+    // Show the given line, or the last line if there are fewer, at the
+    // top of the viewer.
+    void view_line(std::size_t target) {
+        FileView::Line line = viewer->file.find_line(target);
+        viewer->top_line = line.number;
+        viewer->top_offset = line.offset;
+    }
+
+    // Search the viewed file for the string, starting after the last
+    // match or at the top line, and wrapping around at the end. If it is
+    // found, show the line containing it.
+    void find_in_view(const std::string &search) {
+        FileView &file = viewer->file;
+        const char *data = file.data();
+        std::size_t start =
+            (viewer->match_length != 0 ? viewer->match_offset + 1 : viewer->top_offset);
+        std::boyer_moore_horspool_searcher<std::string::const_iterator> searcher(search.begin(),
+                                                                                 search.end());
+        FindResult result = parallel_find(
+            file.size(), start, [&](std::size_t from, std::size_t to) {
+                // matches may run past to, into the next chunk
+                const char *stop = data + std::min(file.size(), to + search.size() - 1);
+                const char *found = std::search(data + from, stop, searcher);
+                return found == stop ? FindResult::npos : std::size_t(found - data);
+            });
+        file.release(0, file.size());  // do not keep the scanned pages resident
+        if (result.match == FindResult::npos) {
+            set_message("\"" + shorten_string(search) + "\" not found", "Not found");
+            return;
+        }
+        viewer->match_offset = result.match;
+        viewer->match_length = search.size();
+        FileView::Line line = file.line_containing(viewer->match_offset);
+        viewer->top_line = line.number;
+        viewer->top_offset = line.offset;
+        // scroll horizontally if the match would be offscreen
+        std::size_t match_column = viewer->match_offset - line.offset;
+        std::size_t margin = getmaxx(canvas) / 4;
+        viewer->shift = (match_column + search.size() + margin > std::size_t(getmaxx(canvas))
+                             ? match_column - margin
+                             : 0);
+        set_match_message(result);
+    }
+
     // Handle an input character for the given buffer. Returns whether
     // or not the buffer was modified.
     bool handle_buffer_input(Buffer &buffer, int c, int min_char, int max_char,
@@ -407,6 +1059,8 @@ class FemtoEditor {
             while (!is_alphanumeric(buffer) && buffer.editor.forward())
                 ;
         } else if (KeyBindings::is_ignore(c)) {  // do nothing
+        } else if (KeyBindings::is_paste(c)) {
+            return handle_paste(buffer, min_char, max_char);
         } else if (min_char <= c && c <= max_char) {
             buffer.editor.insert(c);
             return true;
@@ -416,6 +1070,29 @@ class FemtoEditor {
         return false;
     }
 
+    // Read pasted text up to the end of the paste and insert it into the
+    // buffer all at once, bypassing key handling. Line endings are
+    // converted as in read_file(); characters outside the accepted
+    // range, and newlines in the minibuffer, are dropped. If no input
+    // arrives for PASTE_TIMEOUT, as when the end of the paste is lost,
+    // what has arrived is inserted. Returns whether anything was.
+    bool handle_paste(Buffer &buffer, int min_char, int max_char) {
+        std::string text;
+        int last = '\0';
+        for (int c; (c = next_input(PASTE_TIMEOUT)) != KeyBindings::PASTE_END && c != ERR;
+             last = c) {
+            if (c == '\r' || (c == '\n' && last != '\r')) {
+                if (&buffer == &editbuffer) {
+                    text.push_back('\n');
+                }
+            } else if (c != '\n' && min_char <= c && c <= max_char) {
+                text.push_back(c);
+            }
+        }
+        buffer.editor.insert(text);
+        return !text.empty();
+    }
+
     // Determine whether the cursor is over an alphanumeric character.
     bool is_alphanumeric(Buffer &buffer) {
         return !buffer.editor.is_at_end() &&
@@ -433,7 +1110,11 @@ class FemtoEditor {
         if (!input.empty()) {
             try {
                 int target = std::stoi(input);
-                goto_line(target);
+                if (viewer) {
+                    view_line(std::max(target, 1));
+                } else {
+                    goto_line(target);
+                }
             } catch (const std::out_of_range &) {
                 set_message("ERROR: Invalid integer", "Invalid integer");
             }
@@ -449,11 +1130,14 @@ class FemtoEditor {
         wrefresh(canvas);
         render_minibuffer();
         wrefresh(bottom_bar);
-        int input;
-        while (!KeyBindings::is_enter(input = getch()) && !KeyBindings::is_cancel(input)) {
+        int input = getch();
+        while (!KeyBindings::is_enter(input) && !KeyBindings::is_cancel(input)) {
             handle_buffer_input(minibuffer, input, min_char, max_char, false);
-            render_minibuffer();
-            wrefresh(bottom_bar);
+            if ((input = pending_input()) == ERR) {  // redraw once input is drained
+                render_minibuffer();
+                wrefresh(bottom_bar);
+                input = getch();
+            }
         }
         if (KeyBindings::is_cancel(input)) {
             clear_line(minibuffer);
@@ -464,11 +1148,8 @@ class FemtoEditor {
 
     // Go to the start of a specific line in the text.
     void goto_line(int target) {
-        editbuffer.editor.move_to_row_start();
-        while (editbuffer.editor.get_row() < target && editbuffer.editor.down())
-            ;
-        while (editbuffer.editor.get_row() > target && editbuffer.editor.up())
-            ;
+        PROFILE_SCOPE("goto_line");
+        editbuffer.editor.seek_row_col(std::max(target, 1), 0);
     }
 
     // Read a search string in the minibuffer, attempt to find it, and
@@ -482,7 +1163,7 @@ class FemtoEditor {
         }
         minibuffer.set_prefix(prefix, "Search: ");
         clear_line(minibuffer);
-        if (!get_minibuffer_input(KeyBindings::MIN_CHAR, KeyBindings::MAX_CHAR)) {
+        if (!get_minibuffer_input(KeyBindings::MIN_CHAR, KeyBindings::MAX_BYTE)) {
             set_message("Canceled", "Canceled");
             return;
         }
@@ -494,110 +1175,257 @@ class FemtoEditor {
             search = previous_search;
         }
         previous_search = search;
+        if (viewer) {
+            find_in_view(search);
+            return;
+        }
 
-        // save old position, in case the string is not found
-        int old_row = editbuffer.editor.get_row();
-        int old_column = editbuffer.editor.get_column();
-        editbuffer.editor.forward();  // skip current char
-        if (!find_helper(editbuffer.editor, search)) {
-            // try again from beginning
-            goto_line(1);
-            if (!find_helper(editbuffer.editor, search, old_row, old_column + 1)) {
-                set_message("\"" + shorten_string(search) + "\" not found", "Not found");
-                // restore old position
-                goto_line(old_row);
-                editbuffer.editor.move_to_column(old_column);
-                return;
-            }
+        start_search(search);
+    }
+
+    // Start searching for the string from the cursor in a worker thread,
+    // canceling any earlier search.
+    void start_search(const std::string &search) {
+        background_search.reset();
+        snapshots.publish();
+        background_search = std::make_unique<BackgroundSearch>(snapshots, search,
+                                                               editbuffer.editor.get_index());
+    }
+
+    // If the background search is done, go to the match it found, or
+    // search again if the text has changed since its snapshot. Returns
+    // whether the screen needs to be redrawn.
+    bool finish_search() {
+        if (!background_search || !background_search->done) {
+            return false;
+        }
+        std::unique_ptr<BackgroundSearch> search = std::move(background_search);
+        if (snapshots.dirty() || search->version != snapshots.version()) {
+            start_search(search->search);  // the match may have moved
+            return false;
+        }
+        if (search->result.match == FindResult::npos) {
+            set_message("\"" + shorten_string(search->search) + "\" not found", "Not found");
+        } else {
+            editbuffer.editor.seek(search->result.match);
+            set_match_message(search->result);
         }
-        // found string, need to move backwards to its beginning
-        for (std::size_t i = 1; i < search.size(); ++i, editbuffer.editor.backward())
-            ;
-        if (editbuffer.editor.get_row() < old_row ||
-            (editbuffer.editor.get_row() == old_row &&
-             editbuffer.editor.get_column() <= old_column)) {
-            set_message("Search wrapped", "Search wrapped");
+        return true;
+    }
+
+    // Show which match of how many was found, and whether the search
+    // wrapped around, as in "Match 3 of 12,408".
+    void set_match_message(const FindResult &result) {
+        std::string count = group_digits(result.number) + " of " + group_digits(result.total);
+        if (result.wrapped) {
+            set_message("Search wrapped, match " + count, "Wrapped, " + count);
         } else {
-            set_message("", "");
+            set_message("Match " + count, count);
         }
     }
 
-    // Search the given buffer for the string. If max_row and max_column
-    // are provided, the search ends upon exceeding that position by the
-    // size of the search string.
-    bool find_helper(Editor &editor, const std::string &search, int max_row = -1,
-                     int max_column = -1) {
-        int value_index = 0;
-        for (; !editor.is_at_end() &&
-               (value_index != 0  // in the middle of matching
-                || max_row == -1 || editor.get_row() < max_row ||
-                (editor.get_row() == max_row && editor.get_column() < max_column));
-             editor.forward()) {
-            if (search[value_index] == editor.data_at_cursor()) {
-                ++value_index;
-            } else {
-                value_index = 0;  // reset to beginning of search string
-            }
-            if (value_index == static_cast<int>(search.size())) {
-                return true;  // matched all characters in search string
-            }
+    // Return the given number with its digits in groups of three.
+    static std::string group_digits(std::size_t number) {
+        std::string digits = std::to_string(number);
+        for (int i = static_cast<int>(digits.size()) - 3; i > 0; i -= 3) {
+            digits.insert(i, ",");
         }
-        return false;
+        return digits;
     }
 
-    // Get previous character in buffer. Returns -1 if there is none.
-    int get_previous(Buffer &buffer) {
-        int value = -1;
-        if (buffer.editor.backward()) {
-            value = buffer.editor.data_at_cursor();
-            buffer.editor.forward();
+    // Return the offset of the first occurrence of search in the snapshot
+    // that starts in [from, to) and consists of whole characters, or
+    // Snapshot::npos if there is none or the search is canceled.
+    static std::size_t find_characters(const Snapshot &snapshot, const std::string &search,
+                                       std::size_t from, std::size_t to,
+                                       const std::atomic<bool> &canceled) {
+        std::size_t match;
+        while ((match = snapshot.find(search, from, to, &canceled)) != Snapshot::npos &&
+               !(starts_character(snapshot, match) &&
+                 starts_character(snapshot, match + search.size()))) {
+            from = match + 1;
+        }
+        return match;
+    }
+
+    // Return whether the byte at the given offset in the snapshot starts
+    // a character, as the Editor moves over them, or is at the end.
+    static bool starts_character(const Snapshot &snapshot, std::size_t offset) {
+        if (offset == 0 || offset >= snapshot.size()) {
+            return true;
         }
-        return value;
+        std::size_t before = std::min<std::size_t>(offset, 3);  // room for a joiner
+        std::string text = snapshot.copy(offset - before, before + 4);
+        const char *at = text.c_str() + before;
+        return !Editor::is_continuation(*at) &&
+               (Editor::is_ascii(*at) ||
+                !(Editor::is_combining(Editor::decode(at)) ||
+                  (before == 3 && text.compare(0, 3, "\xE2\x80\x8D") == 0)));
+    }
+
+    // Go to a specific row and column in the text.
+    void goto_position(int row, int column) {
+        editbuffer.editor.seek_row_col(std::max(row, 1), std::max(column, 0));
     }
 
     // Clear the contents of the current line and return the contents.
     std::string clear_line(Buffer &buffer) {
-        std::string line;
-        buffer.editor.move_to_row_end();
-        if (buffer.editor.forward()) {
-            line.push_back('\n');
-            buffer.editor.remove();
+        buffer.editor.move_to_row_start();
+        return buffer.editor.erase_to_row_end();
+    }
+
+    // Remove the current line, saving it in cut_value. The lines removed
+    // by consecutive CUTs are saved together, given whether the last
+    // input was a CUT. Each CUT is handled like other input, so a run
+    // of them is batched and redrawn at the frame rate.
+    void handle_cut(bool continuing) {
+        std::string line = clear_line(editbuffer);
+        if (line.empty()) {
+            set_message("Nothing to cut", "Nothing to cut");
+            cutting = continuing;
+            return;
+        }
+        if (continuing) {
+            cut_value += line;
+        } else {
+            cut_value = line;
+            cut_rectangular = false;
+        }
+        set_modified();
+        cutting = true;
+    }
+
+    // Set the mark at the cursor, or unset it if a mark of the same kind
+    // is already set.
+    void handle_mark(bool rectangular) {
+        if (selection.active && selection.rectangular == rectangular) {
+            selection.active = false;
+            set_message("Mark unset", "Mark unset");
+        } else {
+            selection = {true,
+                         rectangular,
+                         editbuffer.editor.get_row(),
+                         editbuffer.editor.get_column(),
+                         editbuffer.editor.get_index(),
+                         false};
+            set_message(rectangular ? "Block mark set" : "Mark set",
+                        rectangular ? "Block mark set" : "Mark set");
+        }
+    }
+
+    // Keep the mark on the same character after an edit that removed
+    // the given number of bytes at index and inserted others. A mark in
+    // the removed text moves to the start of the edit, and text inserted
+    // at the mark goes after it.
+    void move_mark(int index, int removed_bytes, int inserted_bytes) {
+        if (selection.mark_index > index + removed_bytes) {
+            selection.mark_index += inserted_bytes - removed_bytes;
+        } else if (selection.mark_index > index) {
+            selection.mark_index = index;
+        } else {
+            return;  // the edit is after the mark
         }
-        int ch;
-        while ((ch = get_previous(buffer)) && ch != -1 && ch != '\n') {
-            line.push_back(static_cast<char>(ch));
-            buffer.editor.remove();
+        selection.moved = true;
+    }
+
+    // Find the row and column of the mark again if an edit has moved it.
+    void update_mark() {
+        if (!selection.active || !selection.moved) {
+            return;
+        }
+        Editor &editor = editbuffer.editor;
+        Editor::Position cursor = editor.get_position();
+        editor.seek(selection.mark_index);
+        selection.mark_row = editor.get_row();
+        selection.mark_column = editor.get_column();
+        editor.set_position(cursor);
+        selection.moved = false;
+    }
+
+    // Copy the selection into cut_value without modifying the buffer.
+    void handle_copy() {
+        if (!selection.active) {
+            set_message("No mark set", "No mark set");
+            return;
         }
-        std::reverse(line.begin(), line.end());
-        return line;
+        take_selection(false);
     }
 
-    // Remove each line as long as CUT is input, saving them in
-    // cut_value. Handles the input following the last CUT and returns
-    // the result.
-    bool handle_cut() {
-        std::string new_cut_value;
-        int input = KeyBindings::CUT;
-        while (KeyBindings::is_cut(input)) {
-            std::string line = clear_line(editbuffer);
-            if (line.empty()) {
-                set_message("Nothing to cut", "Nothing to cut");
+    // Save the selected text in cut_value, removing it from the buffer
+    // if cut is true, and unset the mark. Each row of the selection is
+    // taken in one bulk buffer operation, without re-rendering. After a
+    // cut the cursor is at the start of the selection; after a copy it
+    // is left where it was.
+    void take_selection(bool cut) {
+        Editor &editor = editbuffer.editor;
+        std::string value;
+        if (selection.rectangular) {
+            update_mark();
+            int old_row = editor.get_row();
+            int old_column = editor.get_column();
+            int top = std::min(selection.mark_row, old_row);
+            int bottom = std::max(selection.mark_row, old_row);
+            int left = std::min(selection.mark_column, old_column);
+            int right = std::max(selection.mark_column, old_column);
+            for (int row = top; row <= bottom; ++row) {
+                goto_position(row, right);
+                int stop = editor.get_index();
+                editor.move_to_column(left);
+                int count = stop - editor.get_index();
+                value += (cut ? editor.erase(count) : editor.copy(count));
+                if (row != bottom) {
+                    value.push_back('\n');
+                }
             }
-            new_cut_value += line;
-            set_modified(!new_cut_value.empty());  // update status before
-            render_all();                          // re-rendering
-            input = getch();
+            goto_position(cut ? top : old_row, cut ? left : old_column);
+        } else {
+            int start = std::min(selection.mark_index, editor.get_index());
+            int stop = std::max(selection.mark_index, editor.get_index());
+            Editor::Position cursor = editor.get_position();
+            editor.seek(start);  // does not move if the cursor is the start
+            value = (cut ? editor.erase(stop - start) : editor.copy(stop - start));
+            if (!cut) {
+                editor.set_position(cursor);
+            }
+        }
+        selection.active = false;
+
+        // a block is empty if all of its rows are
+        if (value.empty() ||
+            (selection.rectangular && value.find_first_not_of('\n') == std::string::npos)) {
+            set_message(cut ? "Nothing to cut" : "Nothing to copy",
+                        cut ? "Nothing to cut" : "Nothing to copy");
+            return;
+        }
+        cut_value = value;
+        cut_rectangular = selection.rectangular;
+        set_modified(cut);
+    }
+
+    // Determine whether the given position in the edit buffer is within
+    // the selection, given the position of the cursor.
+    bool is_selected(int row, int column, int cursor_row, int cursor_column) {
+        if (!selection.active) {
+            return false;
         }
-        if (!new_cut_value.empty()) {
-            cut_value = new_cut_value;
+        if (selection.rectangular) {
+            return std::min(selection.mark_row, cursor_row) <= row &&
+                   row <= std::max(selection.mark_row, cursor_row) &&
+                   std::min(selection.mark_column, cursor_column) <= column &&
+                   column < std::max(selection.mark_column, cursor_column);
         }
-        return handle_edit_input(input);  // handle last user input
+        std::pair<int, int> position = {row, column};
+        std::pair<int, int> mark = {selection.mark_row, selection.mark_column};
+        std::pair<int, int> cursor = {cursor_row, cursor_column};
+        return std::min(mark, cursor) <= position && position < std::max(mark, cursor);
     }
 
     // Insert all characters from cut_value into the buffer.
     void handle_uncut() {
-        for (std::size_t i = 0; i < cut_value.size(); ++i) {
-            editbuffer.editor.insert(cut_value[i]);
+        if (cut_rectangular) {
+            uncut_rectangle();
+        } else {
+            editbuffer.editor.insert(cut_value);
         }
         set_modified(!cut_value.empty());
         if (cut_value.empty()) {
@@ -605,6 +1433,29 @@ class FemtoEditor {
         }
     }
 
+    // Insert the column block in cut_value with its top left corner at
+    // the cursor, padding short rows with spaces and adding rows at the
+    // end of the buffer as needed. The cursor does not move.
+    void uncut_rectangle() {
+        Editor &editor = editbuffer.editor;
+        int top = editor.get_row();
+        int left = editor.get_column();
+        std::size_t start = 0;
+        for (int row = top; start <= cut_value.size(); ++row) {
+            std::size_t stop = std::min(cut_value.find('\n', start), cut_value.size());
+            goto_line(row);
+            if (editor.get_row() != row) {  // past the last row
+                editor.move_to_row_end();
+                editor.insert('\n');
+            }
+            editor.move_to_column(left);
+            editor.insert(std::string(left - editor.get_column(), ' '));
+            editor.insert(cut_value.substr(start, stop - start));
+            start = stop + 1;
+        }
+        goto_position(top, left);
+    }
+
     // Mark buffer as modified if argument is true.
     void set_modified(bool modify = true, bool force_overwrite = false) {
         if (modify) {
@@ -639,17 +1490,13 @@ class FemtoEditor {
     // Handle pageup and pagedown events.
     void move_page(int offset) {
         int column = editbuffer.editor.get_column();
-        // move cursor first
-        for (bool moving = true;  // handle hitting the last row
-             moving && editbuffer.editor.get_row() < baseline + offset;
-             moving = editbuffer.editor.down())
-            ;
-        for (bool moving = true;  // handle hitting the first row
-             moving && editbuffer.editor.get_row() > baseline + offset;
-             moving = editbuffer.editor.up())
-            ;
-        // restore column
-        editbuffer.editor.move_to_column(column);
+        // move cursor first, seeking from the nearest checkpoint rather
+        // than walking the page row by row
+        int target = std::max(1, baseline + offset);
+        editbuffer.editor.seek_row_col(target, column);
+        if (editbuffer.editor.get_row() < target) {  // hit the last row
+            editbuffer.editor.seek_row_col(editbuffer.editor.get_row(), column);
+        }
         // set new baseline
         if (editbuffer.editor.get_row() == 1) {
             baseline = 1;
@@ -679,7 +1526,7 @@ class FemtoEditor {
         for (char ch : filename) {
             minibuffer.editor.insert(ch);
         }
-        get_minibuffer_input(KeyBindings::MIN_CHAR, KeyBindings::MAX_CHAR);
+        get_minibuffer_input(KeyBindings::MIN_CHAR, KeyBindings::MAX_BYTE);
         std::string file_to_write = minibuffer.editor.stringify();
         if (!file_to_write.empty()) {
             return write_file(file_to_write);
@@ -689,8 +1536,142 @@ class FemtoEditor {
         }
     }
 
-    // Handle exit confirmation.
+    // Handle open dialogue, switching to the file's buffer if it is
+    // already open.
+    void handle_open() {
+        minibuffer.set_prefix("File to open (^N to cancel): ", "Open: ");
+        clear_line(minibuffer);
+        get_minibuffer_input(KeyBindings::MIN_CHAR, KeyBindings::MAX_BYTE);
+        std::string file_to_open = minibuffer.editor.stringify();
+        if (file_to_open.empty()) {
+            set_message("Canceled", "Canceled");
+            return;
+        }
+        std::size_t index = find_buffer(file_to_open);
+        try {
+            if (index == buffers.size()) {
+                add_buffer(file_to_open);
+            }
+            switch_buffer(index);
+        } catch (const std::runtime_error &e) {
+            set_message(std::string("ERROR: ") + e.what(), "Open FAILED");
+            return;
+        }
+        set_buffer_message();
+    }
+
+    // Switch to the next buffer, wrapping around to the first.
+    void handle_next_buffer() {
+        if (buffers.size() == 1) {
+            set_message("No other buffers are open (^P to open one)", "No other buffers");
+            return;
+        }
+        try {
+            switch_buffer((current_buffer + 1) % buffers.size());
+        } catch (const std::runtime_error &e) {
+            set_message(std::string("ERROR: ") + e.what(), "Switch FAILED");
+            return;
+        }
+        set_buffer_message();
+    }
+
+    // Set the message to show which buffer is current.
+    void set_buffer_message() {
+        std::string number = std::to_string(current_buffer + 1);
+        std::string count = std::to_string(buffers.size());
+        set_message("Buffer " + number + " of " + count + ": " +
+                        (filename.empty() ? "<new file>" : shorten_string(filename)),
+                    "Buffer " + number + "/" + count);
+    }
+
+    // Return the index of the buffer with the given file, or the number
+    // of buffers if it is not open.
+    std::size_t find_buffer(const std::string &file_to_find) const {
+        for (std::size_t i = 0; i < buffers.size(); ++i) {
+            if ((i == current_buffer ? filename : buffers[i].filename) == file_to_find) {
+                return i;
+            }
+        }
+        return buffers.size();
+    }
+
+    // Open the given file in a new buffer after the others, without
+    // switching to it.
+    void add_buffer(const std::string &file_to_open) {
+        int text_id = buffer_store.add(read_text(file_to_open));
+        buffers.push_back({file_to_open, false, "initial", text_id, 0, 1, 1, 0});
+    }
+
+    // Make the buffer with the given index current, storing the text and
+    // state of the current one away. Throws std::runtime_error, leaving
+    // the current buffer unchanged, if either text cannot be stored or
+    // read back.
+    void switch_buffer(std::size_t index) {
+        if (index == current_buffer) {
+            return;
+        }
+        OpenBuffer &next = buffers[index];
+        std::string text = buffer_store.take(next.text_id);
+        OpenBuffer &previous = buffers[current_buffer];
+        try {
+            buffer_store.put(previous.text_id, editbuffer.editor.stringify());
+        } catch (const std::runtime_error &) {
+            buffer_store.put(next.text_id, text);
+            throw;
+        }
+        previous = {filename, modified, status, previous.text_id, editbuffer.editor.get_index(),
+                    baseline, wrap_top_row, wrap_top_line};
+        background_search.reset();  // its result is for the previous text
+        Editor &editor = editbuffer.editor;
+        editor.seek(0);
+        editor.erase(editor.size());
+        editor.insert(text);
+        editor.seek(next.cursor_index);
+        edited_bytes = 0;
+        current_buffer = index;
+        filename = next.filename;
+        modified = next.modified;
+        status = next.status;
+        baseline = next.baseline;
+        wrap_top_row = next.wrap_top_row;
+        wrap_top_line = next.wrap_top_line;
+        cursor_row = editor.get_row();
+        editbuffer.view_column = 0;
+        selection.active = false;
+        highlighter.reset();
+        if (Highlighter::supports(filename)) {
+            highlighter = std::make_unique<Highlighter>();
+        }
+        wclear(canvas);  // nothing on screen carries over
+    }
+
+    // Handle exit confirmation, for the current buffer and then each
+    // other modified one.
     bool handle_exit() {
+        if (!confirm_exit()) {
+            return false;
+        }
+        for (std::size_t i = 0; i < buffers.size(); ++i) {
+            if (i != current_buffer && buffers[i].modified) {
+                try {
+                    switch_buffer(i);
+                } catch (const std::runtime_error &e) {
+                    set_message(std::string("ERROR: ") + e.what(), "Switch FAILED");
+                    return false;  // its changes cannot be reached to save them
+                }
+                set_buffer_message();
+                render_all(false);  // show the buffer being asked about
+                if (!confirm_exit()) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // Ask whether to save the current buffer before exiting, if it is
+    // modified. Returns whether or not exiting should continue.
+    bool confirm_exit() {
         if (modified) {
             minibuffer.set_prefix(
                 "Save modified buffer before "
@@ -722,6 +1703,10 @@ class FemtoEditor {
     void render_top_bars() {
         const char *femto_info = " U-M FEMTO ";
         std::string file_info = (modified ? "** " : "-- ");
+        if (buffers.size() > 1) {
+            file_info += "[" + std::to_string(current_buffer + 1) + "/" +
+                         std::to_string(buffers.size()) + "] ";
+        }
         file_info +=
             (filename.empty() ? "<new file>"
                               : shorten_string(filename, std::min<int>(MAX_SHORT_STRING_LENGTH,
@@ -730,6 +1715,15 @@ class FemtoEditor {
         std::string position_info = std::to_string(percentage) + "% (" +
                                     std::to_string(editbuffer.editor.get_row()) + "," +
                                     std::to_string(editbuffer.editor.get_column()) + ") ";
+        if (viewer) {
+            position_info = std::to_string(percentage) + "% (" +
+                            std::to_string(viewer->top_line) + "," +
+                            std::to_string(viewer->shift) + ") ";
+            if (!viewer->file.indexing_done()) {
+                position_info += "[indexed " + std::to_string(viewer->file.line_count()) +
+                                 " lines] ";
+            }
+        }
         reset_bar(top_bar);
         werase(overflow_bar);
         int info_length =
@@ -738,15 +1732,26 @@ class FemtoEditor {
             waddstr(top_bar, femto_info);
         }
         waddstr(top_bar, file_info.c_str());
-        if (info_length - int(std::strlen(femto_info)) <= getmaxx(top_bar)) {
+        bool overflow = info_length - int(std::strlen(femto_info)) > getmaxx(top_bar);
+        if (overflow || show_frame_stats) {
+            reset_bar(overflow_bar);
+        }
+        if (!overflow) {
             waddstr(top_bar, position_info.c_str());
             waddstr(top_bar, status.c_str());
         } else {
-            reset_bar(overflow_bar);
             waddstr(overflow_bar, position_info.c_str());
             waddstr(overflow_bar, status.c_str());
-            wattroff(overflow_bar, A_REVERSE);
         }
+        if (show_frame_stats) {  // after the overflow, if any
+            char stats[100];
+            std::snprintf(stats, sizeof(stats),
+                          " %.0f fps max | %ld frames, %ld dropped | render %.2f ms, avg %.2f ms",
+                          max_fps, frame_stats.drawn, frame_stats.dropped, frame_stats.last_time,
+                          frame_stats.total_time / std::max(1L, frame_stats.drawn));
+            waddstr(overflow_bar, stats);
+        }
+        wattroff(overflow_bar, A_REVERSE);
         wattroff(top_bar, A_REVERSE);
     }
 
@@ -778,9 +1783,13 @@ class FemtoEditor {
     // Render the command/minibuffer bar at the bottom.
     void render_bottom_bar() {
         reset_bar(bottom_bar);
-        waddstr(bottom_bar,
-                " ^X exit | ^F find | ^A save | ^K cut | ^U uncut"
-                " | ^G goto | ^L redraw");
+        if (viewer) {
+            waddstr(bottom_bar, " ^X exit | ^F find | ^G goto | ^L redraw");
+        } else {
+            waddstr(bottom_bar,
+                    " ^X exit | ^F find | ^A save | ^K cut | ^U uncut"
+                    " | ^G goto | ^L redraw");
+        }
         wattroff(bottom_bar, A_REVERSE);
     }
 
@@ -799,20 +1808,41 @@ class FemtoEditor {
 
     // Render the canvas with the text data.
     void render_canvas(bool highlight_cursor = true) {
+        PROFILE_SCOPE("render_canvas");
         wmove(canvas, 0, 0);
         werase(canvas);
+        if (viewer) {
+            render_view();
+            return;
+        }
+        update_mark();
+        if (std::size_t lines = indexed_line_count()) {  // position by line once all are known
+            percentage = 100.0 * editbuffer.editor.get_row() / lines;
+        } else {
+            percentage = 100LL * editbuffer.editor.get_index() / editbuffer.editor.size();
+        }
+        if (wrap) {
+            render_wrapped(highlight_cursor);
+            return;
+        }
         rebase();
 
         // save current position
         int old_row = editbuffer.editor.get_row();
         int old_column = editbuffer.editor.get_column();
-        percentage = 100LL * editbuffer.editor.get_index() / editbuffer.editor.size();
 
         // display as many rows as fit on the canvas, starting at baseline
+        if (highlighter) {
+            update_highlighting(baseline + getmaxy(canvas) - 1);
+        }
         for (int row = baseline; row < baseline + getmaxy(canvas); ++row) {
             goto_line(row);                            // move to start of target row
             if (editbuffer.editor.get_row() == row) {  // guard against end
-                render_row(editbuffer, old_row, old_column, highlight_cursor);
+                std::vector<Highlighter::Span> spans;
+                if (highlighter) {
+                    spans = highlighter->spans(row, row_text(editbuffer));
+                }
+                render_row(editbuffer, old_row, old_column, highlight_cursor, spans);
             }
         }
 
@@ -826,6 +1856,242 @@ class FemtoEditor {
         }
     }
 
+    // Render the canvas with long rows soft wrapped onto several lines,
+    // starting at the top visual line.
+    void render_wrapped(bool highlight_cursor) {
+        Editor &editor = editbuffer.editor;
+        int cursor_row = editor.get_row();
+        int cursor_column = editor.get_column();
+        int cursor_index = editor.get_index();
+        lay_out_row(cursor_row, cursor_column);
+        scroll_wrapped(cursor_row, layout.line_containing(cursor_row, cursor_column));
+        Editor::Position position = editor.get_position();
+        if (highlighter) {
+            update_highlighting(wrap_top_row + getmaxy(canvas) - 1);
+        }
+
+        // move to the start of the top line
+        int row = wrap_top_row;
+        int line = wrap_top_line;
+        int row_start = 0;  // index of the start of the row
+        std::vector<Highlighter::Span> spans;
+        if (row == cursor_row && !highlighter) {
+            editor.set_position(position);  // avoid scanning back to the row start
+        } else {
+            goto_line(row);
+            row_start = editor.get_index();
+            if (highlighter) {
+                spans = highlighter->spans(row, row_text(editbuffer));
+            }
+        }
+        editor.move_to_column(layout.line_start(row, line));
+
+        for (int y = 0; y < getmaxy(canvas); ++y) {
+            if (line == 0 && y != 0) {  // at the start of a row
+                row_start = editor.get_index();
+                if (highlighter) {
+                    spans = highlighter->spans(row, row_text(editbuffer));
+                }
+            }
+            lay_out_row(row, editor.get_column());
+            int stop = (line + 1 < layout.known_lines(row) ? layout.line_start(row, line + 1)
+                                                            : std::numeric_limits<int>::max());
+            auto span = spans.begin();
+            wmove(canvas, y, 0);
+            for (; editor.get_column() < stop && !editor.is_at_end(); editor.forward()) {
+                char c = editor.data_at_cursor();
+                bool highlight = (highlight_cursor && row == cursor_row &&
+                                  editor.get_column() == cursor_column);
+                bool selected = is_selected(row, editor.get_column(), cursor_row, cursor_column);
+                std::size_t offset = editor.get_index() - row_start;
+                while (span != spans.end() && span->end <= offset) {
+                    ++span;
+                }
+                int color = (span != spans.end() && span->begin <= offset
+                                 ? color_attributes[span->color]
+                                 : A_NORMAL);
+                if (c == '\n') {
+                    display_char(editbuffer, ' ', highlight, selected);
+                    break;
+                } else if (Editor::is_ascii(c)) {
+                    display_char(editbuffer, c == '\r' ? ' ' : c, highlight, selected, color);
+                } else {
+                    display_char(editbuffer, editor.character_at_cursor(), highlight, selected,
+                                 color);
+                }
+            }
+            if (editor.is_at_end()) {
+                if (highlight_cursor && editor.get_index() == cursor_index) {
+                    // add highlighted cursor at the end of the buffer
+                    waddch(canvas, ' ' | A_STANDOUT);
+                }
+                break;
+            } else if (editor.data_at_cursor() == '\n') {
+                editor.forward();
+                ++row;
+                line = 0;
+            } else {
+                ++line;
+            }
+        }
+
+        // restore previous position
+        editor.set_position(position);
+    }
+
+    // Move the top of the soft wrapped view so that the given visual
+    // line of the given row is on the canvas, centering it if it was
+    // offscreen.
+    void scroll_wrapped(int row, int line) {
+        int height = getmaxy(canvas);
+        bool offscreen = (row < wrap_top_row || (row == wrap_top_row && line < wrap_top_line) ||
+                          row - wrap_top_row >= height);
+        if (!offscreen) {
+            // count visual lines from the top line to the given one
+            int lines = line - wrap_top_line;
+            for (int r = wrap_top_row; r < row && lines < height; ++r) {
+                lay_out_row(r);
+                lines += layout.line_count(r);
+            }
+            offscreen = (lines >= height);
+        }
+        if (offscreen) {
+            wrap_top_row = row;
+            wrap_top_line = line;
+            for (int count = height / 2; count > 0; --count) {  // move up half the canvas
+                if (wrap_top_line > 0) {
+                    --wrap_top_line;
+                } else if (wrap_top_row > 1) {
+                    lay_out_row(--wrap_top_row);
+                    wrap_top_line = layout.line_count(wrap_top_row) - 1;
+                } else {
+                    break;
+                }
+            }
+        }
+    }
+
+    // Move the cursor by the given number of visual lines, keeping its
+    // offset from the start of the line if possible.
+    void move_visual_lines(int count) {
+        Editor &editor = editbuffer.editor;
+        for (; count != 0; count += (count < 0 ? 1 : -1)) {
+            int row = editor.get_row();
+            lay_out_row(row, editor.get_column());
+            int line = layout.line_containing(row, editor.get_column());
+            int offset = editor.get_column() - layout.line_start(row, line);
+            if (count < 0 && line > 0) {
+                --line;
+            } else if (count > 0 && line + 1 < layout.known_lines(row)) {
+                ++line;
+                lay_out_row(row, layout.line_start(row, line));
+            } else if (count < 0 ? editor.up() : editor.down() && editor.get_row() != row) {
+                row = editor.get_row();
+                lay_out_row(row, count < 0 ? std::numeric_limits<int>::max() : 0);
+                line = (count < 0 ? layout.line_count(row) - 1 : 0);
+            } else {
+                return;  // at the first or last line
+            }
+            int stop = (line + 1 < layout.known_lines(row) ? layout.line_start(row, line + 1) - 1
+                                                            : std::numeric_limits<int>::max());
+            editor.move_to_column(std::min(layout.line_start(row, line) + offset, stop));
+        }
+    }
+
+    // Lay out the given row of the edit buffer for soft wrapping, as far
+    // as the end of the visual line containing the given column. Only the
+    // part of the row after what is already known is scanned.
+    void lay_out_row(int row, int column = std::numeric_limits<int>::max()) {
+        if (layout.covers(row, column)) {
+            return;
+        }
+        Editor &editor = editbuffer.editor;
+        Editor::Position position = editor.get_position();
+        if (editor.get_row() != row) {
+            goto_line(row);
+        }
+        editor.move_to_column(layout.last_start(row));
+        for (int x = 0; !editor.is_at_end() && editor.data_at_cursor() != '\n';
+             editor.forward()) {
+            char c = editor.data_at_cursor();
+            std::string character;  // all of its bytes, if it is not ASCII
+            if (!Editor::is_ascii(c)) {
+                character = editor.character_at_cursor();
+            }
+            int char_width = character.empty() ? display_width(x, c) : display_width(x, character);
+            if (x + char_width > layout.width() && x > 0) {
+                layout.add_line(row, editor.get_column());
+                if (editor.get_column() > column) {
+                    editor.set_position(position);
+                    return;
+                }
+                x = 0;
+                char_width = character.empty() ? display_width(x, c) : display_width(x, character);
+            }
+            x += char_width;
+        }
+        layout.complete_row(row);
+        editor.set_position(position);
+    }
+
+    // Re-lex the rows of the edit buffer whose highlighting state is
+    // unknown, through the given row. Moves the edit buffer.
+    void update_highlighting(int last_row) {
+        for (int row; (row = highlighter->valid_rows()) < last_row;) {
+            goto_line(row);
+            if (editbuffer.editor.get_row() != row) {
+                break;  // past the end of the text
+            }
+            highlighter->advance(row_text(editbuffer));
+        }
+    }
+
+    // Return the rest of the current row, without its newline.
+    std::string row_text(Buffer &buffer) {
+        return buffer.editor.copy_to_column(std::numeric_limits<int>::max());
+    }
+
+    // Render the canvas with the lines of the viewed file, reading them
+    // directly from the mapping.
+    void render_view() {
+        const FileView &file = viewer->file;
+        const char *data = file.data();
+        int width = getmaxx(canvas);
+        if (file.indexing_done()) {  // position by line once all lines are known
+            percentage = 100.0 * viewer->top_line / file.line_count();
+        } else {
+            percentage = (file.size() != 0 ? 100.0 * viewer->top_offset / file.size() : 0);
+        }
+        std::size_t offset = viewer->top_offset;
+        for (int y = 0; y < getmaxy(canvas); ++y) {
+            std::size_t end = file.line_end(offset);
+            wmove(canvas, y, 0);
+            int x = 0;
+            if (viewer->shift != 0) {
+                // not showing line start - add marker
+                escape_char(canvas, editbuffer.left_overflow_marker, A_NORMAL);
+                x = 1;
+            }
+            for (std::size_t i = offset + std::min(viewer->shift, end - offset); i < end; ++i) {
+                char c = data[i];
+                int char_width = display_width(x, c);
+                if (x + char_width >= width) {
+                    wmove(canvas, y, width - 1);
+                    waddch(canvas, editbuffer.right_overflow_marker);
+                    break;
+                }
+                bool matched = (viewer->match_length != 0 && viewer->match_offset <= i &&
+                                i < viewer->match_offset + viewer->match_length);
+                escape_char(canvas, c == '\r' ? ' ' : c, matched ? A_STANDOUT : A_NORMAL);
+                x += char_width;
+            }
+            if (end == file.size()) {
+                break;  // last line
+            }
+            offset = end + 1;
+        }
+    }
+
     // Handle character escaping when displaying to the given window.
     void escape_char(WINDOW *window, char display, int attributes) {
         if (display == '\b' || display == '\x7f') {
@@ -842,20 +2108,45 @@ class FemtoEditor {
                 waddch(window, buf[i] | attributes);
             }
         } else {
+            PROFILE_COUNT("waddch", 1);
             waddch(window, display | attributes);
         }
     }
 
+    // Display a character that may span several bytes, escaping any that
+    // are not part of a printable UTF-8 encoded code point.
+    void escape_char(WINDOW *window, const std::string &display, int attributes) {
+        for (std::size_t i = 0, length; i < display.size(); i += length) {
+            int width = code_point_width(display.data() + i, display.size() - i, length);
+            if (width < 0) {
+                for (std::size_t j = i; j < i + length; ++j) {
+                    escape_char(window, display[j], attributes);
+                }
+            } else if (length == 1) {
+                escape_char(window, display[i], attributes);
+            } else {
+                PROFILE_COUNT("waddnstr", 1);
+                wattron(window, attributes);
+                waddnstr(window, display.data() + i, length);
+                wattroff(window, attributes);
+            }
+        }
+    }
+
     // Display a character in the window with proper highlighting.
-    void display_char(Buffer &buffer, char display, bool highlight) {
+    template <typename Character>
+    void display_char(Buffer &buffer, const Character &display, bool highlight,
+                      bool selected = false, int color = A_NORMAL) {
         if (highlight && buffer.reverse) {
             wattroff(buffer.window, A_REVERSE);
-            escape_char(buffer.window, display, A_NORMAL);
+            escape_char(buffer.window, display, color);
             wattron(buffer.window, A_REVERSE);
         } else if (highlight) {
-            escape_char(buffer.window, display, A_STANDOUT);
+            escape_char(buffer.window, display, A_STANDOUT | color);
+        } else if (selected) {
+            escape_char(buffer.window, display, A_UNDERLINE | color);
         } else {
-            escape_char(buffer.window, display, A_NORMAL);
+            escape_char(buffer.window, display, color);
         }
     }
 
@@ -869,10 +2160,78 @@ class FemtoEditor {
         }
     }
 
-    // Render the current buffer row in the window.
-    void render_row(Buffer &buffer, int cursor_row, int cursor_column, bool highlight_cursor) {
+    // Compute display width of the given text written at column x.
+    int display_width(int x, const std::string &text) {
+        int start = x;
+        for (std::size_t i = 0, length; i < text.size(); i += length) {
+            if (text.size() - i >= 8 && is_printable_ascii(text.data() + i)) {
+                length = 8;  // fast path: 8 characters of width 1
+                x += 8;
+            } else if (Editor::is_ascii(text[i])) {
+                length = 1;
+                x += display_width(x, text[i]);
+            } else {
+                int width = code_point_width(text.data() + i, text.size() - i, length);
+                if (width >= 0) {
+                    x += width;
+                } else {  // escaped bytes
+                    for (std::size_t j = i; j < i + length; ++j) {
+                        x += char_widths[static_cast<unsigned char>(text[j])];
+                    }
+                }
+            }
+        }
+        return x - start;
+    }
+
+    // Determine whether the 8 bytes starting at the given position are
+    // all printable ASCII, testing them all at once with word arithmetic.
+    static bool is_printable_ascii(const char *bytes) {
+        const std::uint64_t ONES = 0x0101010101010101;
+        const std::uint64_t HIGH_BITS = 0x8080808080808080;
+        std::uint64_t word;
+        std::memcpy(&word, bytes, sizeof(word));
+        // high bit set in a byte below ' ', or in a byte above '~'
+        std::uint64_t below = (word - ONES * ' ') & ~word;
+        std::uint64_t above = (word + ONES * (127 - '~')) | word;
+        return ((below | above) & HIGH_BITS) == 0;
+    }
+
+    // Compute display width of the code point at the start of the given
+    // bytes, setting length to the number of bytes it spans. Returns -1 if
+    // the bytes must be escaped instead, in which case length is the
+    // number of bytes to escape.
+    int code_point_width(const char *bytes, std::size_t size, std::size_t &length) {
+        std::mbstate_t state{};
+        wchar_t code_point;
+        length = std::mbrtowc(&code_point, bytes, size, &state);
+        if (length == static_cast<std::size_t>(-1) || length == static_cast<std::size_t>(-2)) {
+            length = 1;  // not valid in the current locale
+            return -1;
+        } else if (length == 0) {
+            length = 1;  // null character
+            return display_width(0, '\0');
+        } else if (length == 1) {
+            return display_width(0, *bytes);
+        }
+        if (static_cast<std::uint32_t>(code_point) >= 0x10000) {
+            return wcwidth(code_point);
+        }
+        signed char &width = code_point_widths[code_point];
+        if (width == UNKNOWN_WIDTH) {
+            width = wcwidth(code_point);
+        }
+        return width;
+    }
+
+    // Render the current buffer row in the window, coloring it with the
+    // given syntax highlighting spans.
+    void render_row(Buffer &buffer, int cursor_row, int cursor_column, bool highlight_cursor,
+                    const std::vector<Highlighter::Span> &spans = {}) {
         int init_x, init_y;
         getyx(buffer.window, init_y, init_x);  // initial location
+        int row_start = buffer.editor.get_index();
+        auto span = spans.begin();
         render_current_row_prefix(buffer, cursor_row, cursor_column);
         for (int current_row = buffer.editor.get_row();
              !buffer.editor.is_at_end() && buffer.editor.get_row() == current_row;
@@ -882,30 +2241,53 @@ class FemtoEditor {
             // the char. The display character is what gets highlighted if
             // the current position is at that point.
             char display = (c == '\n' || c == '\r') ? ' ' : c;
+            std::string character;  // all of its bytes, if it is not ASCII
+            if (!Editor::is_ascii(c)) {
+                character = buffer.editor.character_at_cursor();
+            }
+            std::size_t offset = buffer.editor.get_index() - row_start;
+            while (span != spans.end() && span->end <= offset) {
+                ++span;
+            }
+            int color = (span != spans.end() && span->begin <= offset
+                             ? color_attributes[span->color]
+                             : A_NORMAL);
             bool highlight = false;
             if (highlight_cursor && buffer.editor.get_row() == cursor_row &&
                 buffer.editor.get_column() == cursor_column) {
                 highlight = true;
             }
+            bool selected = (&buffer == &editbuffer &&
+                             is_selected(buffer.editor.get_row(), buffer.editor.get_column(),
+                                         cursor_row, cursor_column));
 
             int x, y;
             getyx(buffer.window, y, x);  // current location
             if (c == '\n' && x == getmaxx(buffer.window) - 1 && y == init_y) {
                 // Newline (edge case, newline at end of line)
-                display_char(buffer, display, highlight);
+                display_char(buffer, display, highlight, selected, color);
             } else if (c == '\n' && x < getmaxx(buffer.window) - 1) {
                 // Newline (common case)
-                display_char(buffer, display, highlight);
+                display_char(buffer, display, highlight, selected, color);
                 waddch(buffer.window, '\n');
+            } else if (!character.empty()) {
+                // Show a character that is not ASCII, unless it goes off
+                // window (a wide character cannot be partly overwritten)
+                if (display_width(x, character) >= getmaxx(buffer.window) - x) {
+                    wmove(buffer.window, init_y, getmaxx(buffer.window) - 1);
+                    waddch(buffer.window, buffer.right_overflow_marker);
+                    break;
+                }
+                display_char(buffer, character, highlight, selected, color);
             } else if (display_width(x, c) >= getmaxx(buffer.window) - x) {
                 // Character goes off window
-                display_char(buffer, display, highlight);
+                display_char(buffer, display, highlight, selected, color);
                 wmove(buffer.window, init_y, getmaxx(buffer.window) - 1);
                 waddch(buffer.window, buffer.right_overflow_marker);
                 break;
             } else {
                 // Show a regular character (common case)
-                display_char(buffer, display, highlight);
+                display_char(buffer, display, highlight, selected, color);
             }
         }
     }
@@ -931,6 +2313,7 @@ class FemtoEditor {
     // Move the baseline by half the window if the cursor is offscreen.
     // Also set the cursor row and reset the view column if needed.
     void rebase() {
+        PROFILE_SCOPE("rebase");
         if (editbuffer.editor.get_row() < baseline ||
             editbuffer.editor.get_row() >= baseline + getmaxy(canvas)) {
             baseline = std::max(1, editbuffer.editor.get_row() - getmaxy(canvas) / 2);
@@ -944,25 +2327,33 @@ class FemtoEditor {
 
     // Read initial contents of the file.
     void read_file() {
-        std::ifstream input(filename);
+        editbuffer.editor.insert(read_text(filename));  // one insertion for the whole file
+        // move to start of buffer
+        while (editbuffer.editor.get_row() != 1) {
+            editbuffer.editor.up();
+        }
+        editbuffer.editor.move_to_row_start();
+    }
+
+    // Return the contents of the given file, with line endings converted
+    // to LF, or an empty string if it cannot be read.
+    static std::string read_text(const std::string &file_to_read) {
+        std::ifstream input(file_to_read);
         const std::streamsize SIZE = 128;
         char arr[SIZE];
         char last = '\0';
+        std::string text;
         while (input) {
             input.read(arr, SIZE);
             for (std::streamsize i = 0; i < input.gcount(); ++i) {
                 // Convert CR and CRLF to just LF
                 if (last != '\r' || arr[i] != '\n') {
-                    editbuffer.editor.insert(arr[i] == '\r' ? '\n' : arr[i]);
+                    text.push_back(arr[i] == '\r' ? '\n' : arr[i]);
                 }
                 last = arr[i];
             }
         }
-        // move to start of buffer
-        while (editbuffer.editor.get_row() != 1) {
-            editbuffer.editor.up();
-        }
-        editbuffer.editor.move_to_row_start();
+        return text;
     }
 
     // Write the contents of the buffer to the file.
@@ -982,8 +2373,10 @@ class FemtoEditor {
 };
 
 int main(int argc, char **argv) {
-    std::string filename = "";
+    std::setlocale(LC_ALL, "");  // display UTF-8 text if the terminal supports it
+    std::vector<std::string> filenames;
     FemtoEditor::InputMode input_mode = FemtoEditor::FEMTO_INPUT_MODE;
+    bool view_only = false;
     if (argc > 1 && argv[1] == std::string("-r")) {
         input_mode = FemtoEditor::RAW;
         --argc;
@@ -993,6 +2386,29 @@ int main(int argc, char **argv) {
         --argc;
         ++argv;
     }
+    double max_fps = FEMTO_MAX_FPS;
+    if (argc > 2 && argv[1] == std::string("-f")) {  // requires a frame rate
+        try {
+            max_fps = std::stod(argv[2]);
+        } catch (const std::logic_error &) {
+            max_fps = -1;
+        }
+        if (max_fps < 0) {
+            std::cout << "ERROR: Invalid frame rate " << argv[2] << std::endl;
+            return 1;
+        }
+        argc -= 2;
+        argv += 2;
+    }
+    if (argc > 2 && argv[1] == std::string("-l")) {  // requires a filename
+        if (argc > 3) {
+            std::cout << "ERROR: -l views a single file" << std::endl;
+            return 1;
+        }
+        view_only = true;
+        --argc;
+        ++argv;
+    }
     if (argc > 1 && argv[1][0] == '-') {
         std::string arg = argv[1];
         int exit_value = 0;
@@ -1001,9 +2417,13 @@ int main(int argc, char **argv) {
         info += "\nAuthor: Amir Kamil";
         std::string usage = "Usage: ";
         usage += argv[0];
-        usage += " [-r|-t] [filename]";
+        usage += " [-r|-t] [-f fps] [-l filename | filename...]";
         usage += "\n\t-r\tenable raw input mode";
         usage += "\n\t-t\tenable terminal input mode";
+        usage += "\n\t-f\tredraw at most fps times a second (0 for no limit)";
+        usage += "\n\t-l\tview a large file read-only, paging it from disk";
+        usage += "\nEach file is opened in its own buffer; ^] switches to the next one, and";
+        usage += "\n^P opens another.";
         if (arg != "-h" && arg != "-v" && arg != "--help") {
             std::cout << "Unknown option " << arg << "\n";
             exit_value = 1;
@@ -1011,8 +2431,11 @@ int main(int argc, char **argv) {
         std::cout << info << "\n" << usage << std::endl;
         return exit_value;
     }
-    if (argc > 1) {
-        filename = argv[1];
+    filenames.assign(argv + 1, argv + argc);  // each is opened in its own buffer
+    try {
+        FemtoEditor fedit(filenames, input_mode, view_only, max_fps);
+    } catch (const std::runtime_error &e) {
+        std::cout << "ERROR: " << e.what() << std::endl;
+        return 1;
     }
-    FemtoEditor fedit(filename, input_mode);
 }
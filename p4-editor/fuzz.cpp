@@ -0,0 +1,648 @@
+/*
+ * Differential fuzzer for List, IndexedList and Editor. Runs random
+ * sequences of operations on a List<int> or an IndexedList<int>
+ * alongside a std::list<int>, and on an
+ * Editor alongside a simple model that keeps its text in a std::string,
+ * checking that they (and the snapshots published from the Editor's
+ * changes) agree after every operation. A failing sequence is
+ * shrunk to one from which no operation can be removed, and printed.
+ *
+ * Usage: ./fuzz.exe [list|indexed|editor|all] [number of operations] [seed]
+ */
+
+#include <algorithm>  // std::equal
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <list>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Editor.hpp"
+#include "Fuzz.hpp"
+#include "IndexedList.hpp"
+#include "List.hpp"
+#include "Snapshot.hpp"
+
+using namespace std;
+
+const size_t SEQUENCE_LENGTH = 1000;  // operations per sequence
+const size_t FULL_CHECK_INTERVAL = 16;  // operations between full comparisons
+
+////////////////////////////////////////////////////////////////////////////////
+// List<int> and IndexedList<int> against std::list<int>
+
+struct ListOp {
+    enum Kind {
+        PUSH_FRONT,
+        PUSH_BACK,
+        POP_FRONT,
+        POP_BACK,
+        INSERT,  // at the cursor
+        ERASE,   // at the cursor
+        FORWARD,
+        BACKWARD,
+        BEGIN,
+        CLEAR,
+        COPY,  // copy construct, then assign the copy back
+        SELF_ASSIGN,
+        NUM_KINDS
+    };
+    Kind kind;
+    int value;
+};
+
+ostream &operator<<(ostream &os, const ListOp &op) {
+    static const char *const names[] = {"push_front", "push_back", "pop_front", "pop_back",
+                                        "insert",     "erase",     "forward",   "backward",
+                                        "begin",      "clear",     "copy",      "self_assign"};
+    os << names[op.kind];
+    if (op.kind == ListOp::PUSH_FRONT || op.kind == ListOp::PUSH_BACK ||
+        op.kind == ListOp::INSERT) {
+        os << "(" << op.value << ")";
+    }
+    return os;
+}
+
+ListOp generate_list_op(FuzzRandom &random) {
+    // weights keep insertions and removals about even, so lists stay small
+    static const int weights[ListOp::NUM_KINDS] = {8, 8, 6, 6, 10, 8, 12, 12, 3, 1, 1, 1};
+    int pick = random.below(76);
+    int kind = 0;
+    while (pick >= weights[kind]) {
+        pick -= weights[kind++];
+    }
+    return {static_cast<ListOp::Kind>(kind), random.below(1000)};
+}
+
+// Describe a failure after the given operation.
+FuzzFailure list_failure(size_t op_index, const string &what) {
+    return {true, op_index, what};
+}
+
+// Compare the lists in full, walking forward and then backward.
+template <typename ListType>
+string compare_lists(const ListType &actual, const list<int> &reference) {
+    if (actual.size() != static_cast<int>(reference.size())) {
+        return "size " + to_string(actual.size()) + " != " + to_string(reference.size());
+    }
+    typename ListType::ConstIterator it = actual.begin();
+    typename ListType::ConstIterator last;
+    int position = 0;
+    for (int value : reference) {
+        if (it == actual.end() || *it != value) {
+            return "element " + to_string(position) + " differs going forward";
+        }
+        last = it;
+        ++it;
+        ++position;
+    }
+    if (it != actual.end()) {
+        return "list is longer than its size";
+    }
+    if (!reference.empty() && --actual.end() != last) {
+        return "--end() is not the last element";
+    }
+    for (auto rit = reference.rbegin(); rit != reference.rend(); ++rit) {
+        --position;
+        if (*last != *rit) {
+            return "element " + to_string(position) + " differs going backward";
+        }
+        if (position > 0) {
+            --last;
+        }
+    }
+    if (!equal(actual.rbegin(), actual.rend(), reference.rbegin(), reference.rend())) {
+        return "reverse iteration differs";
+    }
+    return "";
+}
+
+// Check that the cursor is at the given index, for lists that can tell.
+string check_index(const List<int> &, List<int>::ConstIterator, int) {
+    return "";
+}
+
+string check_index(const IndexedList<int> &actual, IndexedList<int>::ConstIterator cursor,
+                   int cursor_index) {
+    if (actual.index_of(cursor) != cursor_index) {
+        return "index_of(cursor) " + to_string(actual.index_of(cursor)) +
+               " != " + to_string(cursor_index);
+    }
+    if (actual.iterator_at(cursor_index) != cursor) {
+        return "iterator_at(" + to_string(cursor_index) + ") is not the cursor";
+    }
+    return "";
+}
+
+template <typename ListType>
+FuzzFailure run_list_ops(const vector<ListOp> &ops) {
+    ListType actual;
+    list<int> reference;
+    typename ListType::Iterator cursor = actual.begin();
+    auto ref_cursor = reference.begin();
+    int cursor_index = 0;
+    for (size_t i = 0; i < ops.size(); ++i) {
+        const ListOp &op = ops[i];
+        bool at_end = (ref_cursor == reference.end());
+        switch (op.kind) {
+        case ListOp::PUSH_FRONT:
+            actual.push_front(op.value);
+            reference.push_front(op.value);
+            ++cursor_index;  // the cursor stays on the same element, or at the end
+            break;
+        case ListOp::PUSH_BACK:
+            actual.push_back(op.value);
+            reference.push_back(op.value);
+            cursor_index += (at_end ? 1 : 0);  // the end moves past the new element
+            break;
+        case ListOp::POP_FRONT:
+        case ListOp::POP_BACK:
+            if (reference.empty()) {
+                continue;
+            }
+            if (op.kind == ListOp::POP_FRONT) {
+                actual.pop_front();
+                reference.pop_front();
+            } else {
+                actual.pop_back();
+                reference.pop_back();
+            }
+            // the cursor may have been invalidated
+            cursor = actual.begin();
+            ref_cursor = reference.begin();
+            cursor_index = 0;
+            break;
+        case ListOp::INSERT:
+            cursor = actual.insert(cursor, op.value);
+            ref_cursor = reference.insert(ref_cursor, op.value);
+            break;
+        case ListOp::ERASE:
+            if (at_end) {
+                continue;
+            }
+            cursor = actual.erase(cursor);
+            ref_cursor = reference.erase(ref_cursor);
+            break;
+        case ListOp::FORWARD:
+            if (!at_end) {
+                ++cursor;
+                ++ref_cursor;
+                ++cursor_index;
+            }
+            break;
+        case ListOp::BACKWARD:
+            if (cursor_index == 0) {
+                continue;
+            }
+            if (at_end) {  // end() cannot be decremented, so walk from the start
+                cursor = actual.begin();
+                for (int j = 0; j < cursor_index - 1; ++j) {
+                    ++cursor;
+                }
+            } else {
+                --cursor;
+            }
+            --ref_cursor;
+            --cursor_index;
+            break;
+        case ListOp::BEGIN:
+        case ListOp::CLEAR:
+        case ListOp::COPY:
+        case ListOp::SELF_ASSIGN:
+            if (op.kind == ListOp::CLEAR) {
+                actual.clear();
+                reference.clear();
+            } else if (op.kind == ListOp::COPY) {
+                ListType copy(actual);
+                string difference = compare_lists(copy, reference);
+                if (!difference.empty()) {
+                    return list_failure(i, "copy: " + difference);
+                }
+                actual = copy;
+            } else if (op.kind == ListOp::SELF_ASSIGN) {
+                ListType &alias = actual;
+                actual = alias;
+            }
+            cursor = actual.begin();
+            ref_cursor = reference.begin();
+            cursor_index = 0;
+            break;
+        case ListOp::NUM_KINDS:
+            break;
+        }
+
+        // cheap checks after every operation, and full ones periodically
+        if (actual.size() != static_cast<int>(reference.size()) ||
+            actual.empty() != reference.empty()) {
+            return list_failure(i, "size " + to_string(actual.size()) +
+                                       " != " + to_string(reference.size()));
+        }
+        if (!reference.empty() &&
+            (actual.front() != reference.front() || actual.back() != reference.back())) {
+            return list_failure(i, "front or back differs");
+        }
+        if ((cursor == actual.end()) != (ref_cursor == reference.end()) ||
+            (ref_cursor != reference.end() && *cursor != *ref_cursor)) {
+            return list_failure(i, "element at the cursor differs");
+        }
+        string index_difference = check_index(actual, cursor, cursor_index);
+        if (!index_difference.empty()) {
+            return list_failure(i, index_difference);
+        }
+        if (i % FULL_CHECK_INTERVAL == 0 || i + 1 == ops.size()) {
+            string difference = compare_lists(actual, reference);
+            if (!difference.empty()) {
+                return list_failure(i, difference);
+            }
+        }
+    }
+    return FuzzFailure();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Editor against a std::string model
+
+// Text inserted by the INSERT operation, including multibyte characters.
+const char *const INSERTED_TEXT[] = {"a", "b", " ", "\n", "\xc3\xa9" /* e acute */,
+                                     "\xe2\x82\xac" /* euro sign */,
+                                     "\xf0\x9d\x84\x9e" /* G clef */, "ab\ncd", "\n\n"};
+const int NUM_INSERTED_TEXTS = sizeof(INSERTED_TEXT) / sizeof(INSERTED_TEXT[0]);
+
+struct EditorOp {
+    enum Kind {
+        INSERT_CHAR,    // one ASCII character with insert(char)
+        INSERT_STRING,  // with insert(const string &)
+        REMOVE,
+        ERASE,  // a number of characters
+        ERASE_TO_ROW_END,
+        FORWARD,
+        BACKWARD,
+        UP,
+        DOWN,
+        ROW_START,
+        ROW_END,
+        MOVE_TO_COLUMN,
+        SEEK,          // to an index, modulo the size of the text plus one
+        SEEK_ROW_COL,  // to row 1 + value / 16, column value % 16
+        COMPACT,
+        NUM_KINDS
+    };
+    Kind kind;
+    int value;
+};
+
+ostream &operator<<(ostream &os, const EditorOp &op) {
+    static const char *const names[] = {"insert",    "insert",        "remove",  "erase",
+                                        "erase_to_row_end", "forward", "backward", "up",
+                                        "down",      "move_to_row_start", "move_to_row_end",
+                                        "move_to_column", "seek", "seek_row_col", "compact"};
+    os << names[op.kind];
+    if (op.kind == EditorOp::INSERT_CHAR || op.kind == EditorOp::INSERT_STRING) {
+        string text = (op.kind == EditorOp::INSERT_CHAR ? string(1, char(op.value))
+                                                         : INSERTED_TEXT[op.value]);
+        os << (op.kind == EditorOp::INSERT_CHAR ? "('" : "(\"");
+        for (char c : text) {
+            if (c == '\n') {
+                os << "\\n";
+            } else if (static_cast<unsigned char>(c) >= 0x80) {
+                os << "\\x" << hex << (static_cast<unsigned char>(c)) << dec;
+            } else {
+                os << c;
+            }
+        }
+        os << (op.kind == EditorOp::INSERT_CHAR ? "')" : "\")");
+    } else if (op.kind == EditorOp::SEEK_ROW_COL) {
+        os << "(" << 1 + op.value / 16 << ", " << op.value % 16 << ")";
+    } else if (op.kind == EditorOp::ERASE || op.kind == EditorOp::MOVE_TO_COLUMN ||
+               op.kind == EditorOp::SEEK) {
+        os << "(" << op.value << ")";
+    }
+    return os;
+}
+
+EditorOp generate_editor_op(FuzzRandom &random) {
+    static const int weights[EditorOp::NUM_KINDS] = {14, 8, 8, 3, 2, 12, 12, 8, 8, 3, 3, 3, 4, 4, 1};
+    static const char ascii[] = {'a', 'b', ' ', '\n'};
+    int pick = random.below(93);
+    int kind = 0;
+    while (pick >= weights[kind]) {
+        pick -= weights[kind++];
+    }
+    int value = random.below(6);
+    if (kind == EditorOp::INSERT_CHAR) {
+        value = ascii[random.below(4)];
+    } else if (kind == EditorOp::INSERT_STRING) {
+        value = random.below(NUM_INSERTED_TEXTS);
+    } else if (kind >= EditorOp::SEEK) {
+        value = random.below(256);
+    }
+    return {static_cast<EditorOp::Kind>(kind), value};
+}
+
+class EditorModel {
+    // OVERVIEW: the text of an editor and a cursor into it, as a byte
+    //           offset. The text is always valid UTF-8 without combining
+    //           marks, so each character is a newline or one code point.
+   public:
+    string text;
+    size_t cursor = 0;
+
+    static bool is_continuation(char c) {
+        return (static_cast<unsigned char>(c) & 0xc0) == 0x80;
+    }
+
+    // Return the offset just past the character at the given offset.
+    size_t character_end(size_t offset) const {
+        if (offset >= text.size()) {
+            return offset;
+        }
+        do {
+            ++offset;
+        } while (offset < text.size() && is_continuation(text[offset]));
+        return offset;
+    }
+
+    // Return the offset of the start of the row containing the given
+    // offset.
+    size_t row_start(size_t offset) const {
+        size_t newline = (offset == 0 ? string::npos : text.rfind('\n', offset - 1));
+        return newline == string::npos ? 0 : newline + 1;
+    }
+
+    // Return the offset of the end of the row containing the cursor.
+    size_t row_end() const {
+        size_t newline = text.find('\n', cursor);
+        return newline == string::npos ? text.size() : newline;
+    }
+
+    // Return the offset of the given column in the row that starts at
+    // the given offset, or of the end of the row if it is shorter.
+    size_t column_offset(size_t start, int column) const {
+        for (; column > 0 && start < text.size() && text[start] != '\n'; --column) {
+            start = character_end(start);
+        }
+        return start;
+    }
+
+    int row() const {
+        return 1 + count(text.begin(), text.begin() + cursor, '\n');
+    }
+
+    int column() const {
+        size_t start = row_start(cursor);
+        return count_if(text.begin() + start, text.begin() + cursor,
+                        [](char c) { return !is_continuation(c); });
+    }
+
+    bool backward() {
+        if (cursor == 0) {
+            return false;
+        }
+        do {
+            --cursor;
+        } while (cursor > 0 && is_continuation(text[cursor]));
+        return true;
+    }
+
+    bool up() {
+        size_t start = row_start(cursor);
+        if (start == 0) {
+            return false;
+        }
+        cursor = column_offset(row_start(start - 1), column());
+        return true;
+    }
+
+    bool down() {
+        if (cursor == text.size()) {
+            return false;
+        }
+        int old_column = column();
+        size_t end = row_end();
+        cursor = (end == text.size() ? end : column_offset(end + 1, old_column));
+        return true;
+    }
+
+    // Return the offset of the given column in the given row, or of the
+    // end of the text if there are not that many rows.
+    size_t seek_row_col(int new_row, int new_column) const {
+        size_t start = 0;
+        for (int r = 1; r < new_row; ++r) {
+            start = text.find('\n', start);
+            if (start == string::npos) {
+                return text.size();
+            }
+            ++start;
+        }
+        return column_offset(start, new_column);
+    }
+
+    // Return the offset just past the given number of characters from
+    // the cursor.
+    size_t characters_end(int count) const {
+        size_t end = cursor;
+        for (; count > 0 && end < text.size(); --count) {
+            end = character_end(end);
+        }
+        return end;
+    }
+};
+
+// Describe a difference after the given operation.
+template <typename T>
+FuzzFailure editor_failure(size_t op_index, const string &what, const T &actual,
+                           const T &expected) {
+    ostringstream message;
+    message << what << ": got " << actual << ", expected " << expected;
+    return {true, op_index, message.str()};
+}
+
+FuzzFailure run_editor_ops(const vector<EditorOp> &ops) {
+    Editor editor(4);  // checkpoint often, to exercise keeping them up to date
+    EditorModel model;
+    SnapshotPublisher snapshots;  // kept up to date from the editor's changes
+    editor.set_change_callback([&snapshots](int index, int removed_bytes, string_view inserted) {
+        snapshots.erase(index, removed_bytes);
+        snapshots.insert(index, inserted);
+    });
+    for (size_t i = 0; i < ops.size(); ++i) {
+        const EditorOp &op = ops[i];
+        string result;
+        string expected_result;
+        switch (op.kind) {
+        case EditorOp::INSERT_CHAR:
+            editor.insert(char(op.value));
+            model.text.insert(model.cursor, 1, char(op.value));
+            ++model.cursor;
+            break;
+        case EditorOp::INSERT_STRING:
+            editor.insert(string(INSERTED_TEXT[op.value]));
+            model.text.insert(model.cursor, INSERTED_TEXT[op.value]);
+            model.cursor += string(INSERTED_TEXT[op.value]).size();
+            break;
+        case EditorOp::REMOVE: {
+            size_t end = model.cursor;
+            bool removed = model.backward();
+            model.text.erase(model.cursor, end - model.cursor);
+            result = to_string(editor.remove());
+            expected_result = to_string(removed);
+            break;
+        }
+        case EditorOp::ERASE: {
+            size_t end = model.characters_end(op.value);
+            expected_result = model.text.substr(model.cursor, end - model.cursor);
+            model.text.erase(model.cursor, end - model.cursor);
+            result = editor.erase(expected_result.size());
+            break;
+        }
+        case EditorOp::ERASE_TO_ROW_END: {
+            size_t end = model.row_end();
+            end += (end < model.text.size() ? 1 : 0);  // the newline
+            expected_result = model.text.substr(model.cursor, end - model.cursor);
+            model.text.erase(model.cursor, end - model.cursor);
+            result = editor.erase_to_row_end();
+            break;
+        }
+        case EditorOp::FORWARD:
+            result = to_string(editor.forward());
+            expected_result = to_string(model.cursor < model.text.size());
+            model.cursor = model.character_end(model.cursor);
+            break;
+        case EditorOp::BACKWARD:
+            result = to_string(editor.backward());
+            expected_result = to_string(model.backward());
+            break;
+        case EditorOp::UP:
+            result = to_string(editor.up());
+            expected_result = to_string(model.up());
+            break;
+        case EditorOp::DOWN:
+            result = to_string(editor.down());
+            expected_result = to_string(model.down());
+            break;
+        case EditorOp::ROW_START:
+            editor.move_to_row_start();
+            model.cursor = model.row_start(model.cursor);
+            break;
+        case EditorOp::ROW_END:
+            editor.move_to_row_end();
+            model.cursor = model.row_end();
+            break;
+        case EditorOp::MOVE_TO_COLUMN:
+            editor.move_to_column(op.value);
+            model.cursor = model.column_offset(model.row_start(model.cursor), op.value);
+            break;
+        case EditorOp::SEEK:
+            editor.seek(op.value % (model.text.size() + 1));
+            model.cursor = op.value % (model.text.size() + 1);
+            while (model.cursor < model.text.size() &&
+                   EditorModel::is_continuation(model.text[model.cursor])) {
+                --model.cursor;  // to the start of the character
+            }
+            break;
+        case EditorOp::SEEK_ROW_COL:
+            editor.seek_row_col(1 + op.value / 16, op.value % 16);
+            model.cursor = model.seek_row_col(1 + op.value / 16, op.value % 16);
+            break;
+        case EditorOp::COMPACT:
+            editor.compact();
+            break;
+        case EditorOp::NUM_KINDS:
+            break;
+        }
+
+        // cheap checks after every operation, and full ones periodically
+        if (result != expected_result) {
+            return editor_failure(i, "result", result, expected_result);
+        }
+        if (editor.get_index() != static_cast<int>(model.cursor)) {
+            return editor_failure(i, "index", editor.get_index(), int(model.cursor));
+        }
+        if (editor.get_row() != model.row()) {
+            return editor_failure(i, "row", editor.get_row(), model.row());
+        }
+        if (editor.get_column() != model.column()) {
+            return editor_failure(i, "column", editor.get_column(), model.column());
+        }
+        bool model_at_end = (model.cursor == model.text.size());
+        if (editor.is_at_end() != model_at_end) {
+            return editor_failure(i, "is_at_end", editor.is_at_end(), model_at_end);
+        }
+        if (!model_at_end &&
+            editor.character_at_cursor() !=
+                model.text.substr(model.cursor, model.character_end(model.cursor) - model.cursor)) {
+            return editor_failure(i, "character at cursor", editor.character_at_cursor(),
+                                  model.text.substr(model.cursor, 1));
+        }
+        if (i % FULL_CHECK_INTERVAL == 0 || i + 1 == ops.size()) {
+            string text = editor.stringify();
+            if (text != model.text) {
+                return editor_failure(i, "text", text, model.text);
+            }
+            snapshots.publish();
+            SnapshotPublisher::Reader snapshot(snapshots);
+            text = snapshot->copy(0, snapshot->size());
+            if (text != model.text) {
+                return editor_failure(i, "snapshot", text, model.text);
+            }
+        }
+    }
+    return FuzzFailure();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Fuzz with the given operations, and print the results. Returns whether
+// or not the implementation agreed with its model throughout.
+template <typename Op>
+bool run_campaign(const string &name, uint64_t seed, size_t count,
+                  const FuzzGenerate<Op> &generate, const FuzzRun<Op> &run) {
+    auto start = chrono::steady_clock::now();
+    FuzzReport<Op> report = fuzz(seed, count, SEQUENCE_LENGTH, generate, run);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << name << ": " << report.ops_run << " operations in " << seconds << " s ("
+         << report.ops_run / seconds / 1e6 << " million/s)" << endl;
+    if (!report.failed) {
+        return true;
+    }
+    cout << "FAILED with the sequence from seed " << report.seed << ", shrunk to "
+         << report.ops.size() << " operations:" << endl;
+    for (size_t i = 0; i < report.ops.size(); ++i) {
+        cout << "  " << i << ": " << report.ops[i] << endl;
+    }
+    cout << "after operation " << report.failure.op_index << ", " << report.failure.message
+         << endl;
+    return false;
+}
+
+int main(int argc, char *argv[]) {
+    string target = (argc > 1 ? argv[1] : "all");
+    size_t count = (argc > 2 ? strtoull(argv[2], nullptr, 10) : 1000000);
+    uint64_t seed = (argc > 3 ? strtoull(argv[3], nullptr, 10) : 1);
+    if ((target != "list" && target != "indexed" && target != "editor" && target != "all") ||
+        count == 0) {
+        cout << "usage: " << argv[0]
+             << " [list|indexed|editor|all] [number of operations] [seed]" << endl;
+        return 1;
+    }
+    bool passed = true;
+    if (target == "list" || target == "all") {
+        passed = run_campaign<ListOp>("List", seed, count, generate_list_op,
+                                      run_list_ops<List<int>>) &&
+                 passed;
+    }
+    if (target == "indexed" || target == "all") {
+        passed = run_campaign<ListOp>("IndexedList", seed, count, generate_list_op,
+                                      run_list_ops<IndexedList<int>>) &&
+                 passed;
+    }
+    if (target == "editor" || target == "all") {
+        passed = run_campaign<EditorOp>("Editor", seed, count, generate_editor_op,
+                                        run_editor_ops) &&
+                 passed;
+    }
+    return passed ? 0 : 1;
+}
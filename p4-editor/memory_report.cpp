@@ -0,0 +1,116 @@
+/*
+ * Report on the memory used by the Editor: the bytes its text buffer
+ * takes per character stored, the allocations made by each kind of
+ * operation, and the peak resident set size of the process.
+ *
+ * Build with make memory_report.exe, which defines
+ * EDITOR_COUNT_ALLOCATIONS, and run as
+ *   ./memory_report.exe [number of characters]
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <string>
+
+#include "CountingAllocator.hpp"
+#include "Editor.hpp"
+
+using namespace std;
+
+static AllocationCounts global_counts;  // every call to operator new
+
+void *operator new(size_t size) {
+    global_counts.allocated(size);
+    if (void *memory = malloc(size > 0 ? size : 1)) {
+        return memory;
+    }
+    throw bad_alloc();
+}
+
+void operator delete(void *memory) noexcept {
+    free(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept {
+    free(memory);
+}
+
+// Run the given operation the given number of times, and print the
+// allocations and bytes it makes per run.
+void report_operation(const char *name, int runs, const function<void()> &operation) {
+    long allocations = global_counts.allocations;
+    size_t bytes = global_counts.total_bytes;
+    for (int i = 0; i < runs; ++i) {
+        operation();
+    }
+    printf("  %-20s %10.2f %10.1f\n", name,
+           double(global_counts.allocations - allocations) / runs,
+           double(global_counts.total_bytes - bytes) / runs);
+}
+
+int main(int argc, char *argv[]) {
+    int characters = (argc > 1 ? atoi(argv[1]) : 1000000);
+    if (characters <= 0) {
+        cout << "usage: " << argv[0] << " [number of characters]" << endl;
+        return 1;
+    }
+    const int ROW_LENGTH = 80;
+    const int RUNS = 1000;
+
+    Editor editor;
+    const AllocationCounts &text_counts = editor.allocation_counts();
+    size_t empty_bytes = text_counts.live_bytes;  // sentinels
+    string row(ROW_LENGTH - 1, 'x');
+    row += '\n';
+    for (int i = 0; i < characters; ++i) {
+        editor.insert(row[i % ROW_LENGTH]);
+    }
+    double stored = editor.size() - 2;  // not counting the sentinels
+
+    printf("%d characters in %d rows\n", characters, editor.get_row());
+    printf("text buffer: %zu bytes in %ld allocations, %.1f bytes per character\n",
+           text_counts.live_bytes, text_counts.allocations - text_counts.deallocations,
+           (text_counts.live_bytes - empty_bytes) / stored);
+    printf("all allocations: %ld, %.1f bytes per character\n\n", global_counts.allocations,
+           global_counts.total_bytes / stored);
+
+    printf("  %-20s %10s %10s\n", "per operation", "allocs", "bytes");
+    for (int middle = editor.get_row() / 2; editor.get_row() > middle;) {
+        editor.up();  // work on full rows
+    }
+    editor.move_to_row_start();
+    report_operation("insert char", RUNS, [&]() { editor.insert('y'); });
+    report_operation("remove", RUNS, [&]() { editor.remove(); });
+    report_operation("insert 10 chars", RUNS, [&]() { editor.insert(string(10, 'y')); });
+    report_operation("erase 10 chars", RUNS, [&]() {
+        for (int i = 0; i < 10; ++i) {
+            editor.backward();
+        }
+        editor.erase(10);
+    });
+    report_operation("copy 10 chars", RUNS, [&]() { editor.copy(10); });
+    report_operation("forward/backward", RUNS, [&]() {
+        editor.forward();
+        editor.backward();
+    });
+    report_operation("up/down", RUNS, [&]() {
+        editor.up();
+        editor.down();
+    });
+    report_operation("row start/end", RUNS, [&]() {
+        editor.move_to_row_end();
+        editor.move_to_row_start();
+    });
+    report_operation("erase to row end", RUNS, [&]() {
+        string erased = editor.erase_to_row_end();
+        editor.insert(erased);
+        editor.move_to_row_start();
+    });
+    report_operation("stringify", 1, [&]() { editor.stringify(); });
+
+    printf("\npeak resident set size: %.1f MB\n", peak_resident_bytes() / 1e6);
+    return 0;
+}
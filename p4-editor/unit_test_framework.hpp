@@ -14,11 +14,26 @@
 #include <cstdlib>
 #include <iterator>
 #include <algorithm>
+#include <chrono>
 #include <exception>
+#include <fstream>
 #include <stdexcept>
 #if UNIT_TEST_ENABLE_REGEXP
 #  include <regex>
 #endif
+#if UNIT_TEST_COUNT_ALLOCATIONS
+#  include <atomic>
+#  include <new>
+#endif
+// Tests can be run in parallel, each in its own process, where fork() is
+// available.
+#if defined(__unix__) || defined(__APPLE__)
+#  define UNIT_TEST_ENABLE_FORK 1
+#  include <poll.h>
+#  include <sys/wait.h>
+#  include <unistd.h>
+#  include <cstring>
+#endif
 
 // For compatibility with Visual Studio
 #include <ciso646>
@@ -35,6 +50,14 @@ using Test_func_t = void (*)();
     static TestRegisterer register_##name((#name), name);                     \
     static void name()
 
+// Defines a benchmark, which is run after the tests. Its body is given a
+// BenchState named state, and should time its work in a loop such as
+//   while (state.keep_running()) { ... }
+#define BENCH(name)                                                           \
+    static void name(BenchState&);                                            \
+    static BenchRegisterer bench_register_##name((#name), name);              \
+    static void name(BenchState& state)
+
 #define TEST_MAIN()                                                           \
     int main(int argc, char** argv) {                                         \
         return TestSuite::get().run_tests(argc, argv);                        \
@@ -53,6 +76,109 @@ struct TestCase {
     Test_func_t test_func;
     std::string failure_msg{};
     std::string exception_msg{};
+    double elapsed_ms = 0;  // wall time taken by the test
+};
+
+
+// The timing state of one run of a benchmark's body.
+class BenchState {
+public:
+    explicit BenchState(long iterations_)
+        : iterations(iterations_), remaining(iterations_) {}
+
+    // Returns whether the timed loop should run another iteration. Times
+    // from the first call until it returns false.
+    bool keep_running() {
+        if (not started) {
+            started = true;
+            resume_timing();
+        }
+        if (remaining > 0) {
+            --remaining;
+            return true;
+        }
+        pause_timing();
+        return false;
+    }
+
+    // Stops timing, such as for setup inside the loop.
+    void pause_timing() {
+        if (running) {
+            elapsed_ns += std::chrono::duration<double, std::nano>(
+                std::chrono::steady_clock::now() - start).count();
+            running = false;
+        }
+    }
+
+    // Restarts timing after pause_timing().
+    void resume_timing() {
+        if (not running) {
+            start = std::chrono::steady_clock::now();
+            running = true;
+        }
+    }
+
+    // Records how many items or bytes each iteration processes, for
+    // reporting throughput.
+    void set_items_per_iteration(double items) {
+        items_per_iteration = items;
+    }
+    void set_bytes_per_iteration(double bytes) {
+        bytes_per_iteration = bytes;
+    }
+
+    const long iterations;  // number of times the loop runs
+    long remaining;
+    bool started = false;
+    bool running = false;
+    std::chrono::steady_clock::time_point start{};
+    double elapsed_ns = 0;
+    double items_per_iteration = 0;
+    double bytes_per_iteration = 0;
+};
+
+using Bench_func_t = void (*)(BenchState&);
+
+// Keeps the compiler from optimizing away the computation of value.
+template <typename T>
+inline void DoNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+// Keeps the compiler from optimizing away or reordering writes to memory.
+inline void ClobberMemory() {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : : "memory");
+#else
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+}
+
+struct BenchCase {
+    BenchCase(const std::string& name_, Bench_func_t bench_func_)
+        : name(name_), bench_func(bench_func_) {}
+
+    void run(bool quiet_mode, double target_ms, int samples);
+    void print(bool quiet_mode);
+    double percentile_ns(double percent) const;
+
+    std::string name;
+    Bench_func_t bench_func;
+    std::string failure_msg{};
+    std::string exception_msg{};
+    long iterations = 0;  // per sample
+    std::vector<double> sample_ns{};  // time per iteration of each sample,
+                                      // sorted once they are all measured
+    double mean_ns = 0;
+    double stddev_ns = 0;
+    double items_per_iteration = 0;
+    double bytes_per_iteration = 0;
+    double baseline_ns = 0;  // mean from the baseline file, or 0 if none
 };
 
 
@@ -69,8 +195,17 @@ public:
         tests_.insert({test_name, TestCase{test_name, test}});
     }
 
+    void add_bench(const std::string& bench_name, Bench_func_t bench) {
+        benches_.insert({bench_name, BenchCase{bench_name, bench}});
+    }
+
     int run_tests(int argc, char** argv);
     void print_results();
+    void print_slowest(const std::vector<std::string>& test_names);
+#if UNIT_TEST_ENABLE_FORK
+    void run_forked(const std::vector<std::string>& test_names);
+#endif
+    int run_benches(const std::vector<std::string>& bench_names);
 
     void enable_quiet_mode() {
         quiet_mode = true;
@@ -80,6 +215,9 @@ public:
         for (const auto& test_pair : tests_) {
             os << test_pair.first << '\n';
         }
+        for (const auto& bench_pair : benches_) {
+            os << bench_pair.first << '\n';
+        }
         return os;
     }
 
@@ -106,8 +244,16 @@ private:
 
     static TestSuite* instance;
     std::map<std::string, TestCase> tests_;
+    std::map<std::string, BenchCase> benches_;
 
     bool quiet_mode = false;
+    int jobs = 1;     // number of tests to run at once
+    int slowest = 0;  // number of slowest tests to report
+    double bench_ms = 500;  // target time to run each benchmark
+    int bench_samples = 20;  // number of times each benchmark is measured
+    std::string baseline_file{};  // benchmark means to compare against
+    std::string save_file{};      // where to save benchmark means
+    double threshold = 10;  // percent slower than the baseline that fails
     static bool incomplete;
 };
 
@@ -125,6 +271,13 @@ public:
     }
 };
 
+class BenchRegisterer {
+public:
+    BenchRegisterer(const std::string& bench_name, Bench_func_t bench) {
+        TestSuite::get().add_bench(bench_name, bench);
+    }
+};
+
 class TestFailure {
 public:
     TestFailure(std::string reason, int line_number, const char* assertion_text)
@@ -270,6 +423,21 @@ std::ostream& print(std::ostream& os, const T& t) {
                         "ASSERT_ALMOST_EQUAL(" #first ", " #second ", "       \
                         #precision ")");
 
+// Define UNIT_TEST_COUNT_ALLOCATIONS to 1 before including this file to
+// count calls to operator new and enable this assertion, which fails if
+// running the given statement makes more than budget allocations.
+#if UNIT_TEST_COUNT_ALLOCATIONS
+#define ASSERT_ALLOCATIONS_AT_MOST(budget, ...)                               \
+    {                                                                         \
+        long allocations_before = allocation_count();                         \
+        __VA_ARGS__;                                                          \
+        assert_allocations_at_most(allocation_count() - allocations_before,   \
+                                   (budget), __LINE__,                        \
+                                   "ASSERT_ALLOCATIONS_AT_MOST(" #budget      \
+                                   ", " #__VA_ARGS__ ")");                    \
+    }
+#endif
+
 // Template logic to produce a static assertion failure when comparing
 // incomparable types.
 template <typename First, typename Second, typename = void>
@@ -415,6 +583,7 @@ void assert_sequence_equal(First&& first, Second&& second, int line_number,
     TestSuite* TestSuite::instance = &TestSuite::get()
 
 void TestCase::run(bool quiet_mode) {
+    auto start = std::chrono::steady_clock::now();
     try {
         if (not quiet_mode) {
             std::cout << "Running test: " << name << std::endl;
@@ -444,6 +613,8 @@ void TestCase::run(bool quiet_mode) {
             std::cout << "ERROR" << std::endl;
         }
     }
+    elapsed_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
 }
 
 void TestCase::print(bool quiet_mode) {
@@ -502,20 +673,38 @@ int TestSuite::run_tests(int argc, char** argv) {
         return e.status;
     }
 
-    for (auto test_name : test_names_to_run) {
-        if (tests_.find(test_name) == end(tests_)) {
-            throw std::runtime_error("Test " + test_name + " not found");
+    std::vector<std::string> bench_names_to_run;
+    auto bench_start = std::stable_partition(
+        test_names_to_run.begin(), test_names_to_run.end(),
+        [this](const std::string& name) { return tests_.count(name) > 0; });
+    for (auto iter = bench_start; iter != test_names_to_run.end(); ++iter) {
+        if (benches_.find(*iter) == end(benches_)) {
+            throw std::runtime_error("Test " + *iter + " not found");
         }
+        bench_names_to_run.push_back(*iter);
+    }
+    test_names_to_run.erase(bench_start, test_names_to_run.end());
+    if (test_names_to_run.empty() and not bench_names_to_run.empty()) {
+        return run_benches(bench_names_to_run);
     }
 
-    for (auto test_name : test_names_to_run) {
-        tests_.at(test_name).run(quiet_mode);
+#if UNIT_TEST_ENABLE_FORK
+    if (jobs > 1) {
+        run_forked(test_names_to_run);
+    }
+    else
+#endif
+    {
+        for (auto test_name : test_names_to_run) {
+            tests_.at(test_name).run(quiet_mode);
+        }
     }
 
     std::cout << "\n*** Results ***" << std::endl;
     for (auto test_name : test_names_to_run) {
         tests_.at(test_name).print(quiet_mode);
     }
+    print_slowest(test_names_to_run);
 
     auto num_failures =
         std::count_if(tests_.begin(), tests_.end(),
@@ -536,8 +725,9 @@ int TestSuite::run_tests(int argc, char** argv) {
                   << " error(s)" << std::endl;
     }
 
+    int bench_status = run_benches(bench_names_to_run);
     if (num_failures == 0 and num_errors == 0) {
-        return 0;
+        return bench_status;
     }
     return 1;
 }
@@ -560,6 +750,44 @@ std::vector<std::string> TestSuite::get_test_names_to_run(int argc,
                  argv[i] == std::string("-q")) {
             TestSuite::get().enable_quiet_mode();
         }
+        else if (argv[i] == std::string("--jobs") or
+                 argv[i] == std::string("-j") or
+                 argv[i] == std::string("--slowest") or
+                 argv[i] == std::string("-s") or
+                 argv[i] == std::string("--bench_time") or
+                 argv[i] == std::string("--threshold")) {
+            std::string option = argv[i];
+            double value = (i + 1 < argc ? std::atof(argv[i + 1]) : 0);
+            if (value <= 0) {
+                std::cout << "ERROR: " << option
+                          << " requires a positive number" << std::endl;
+                throw ExitSuite(1);
+            }
+            ++i;
+            if (option == "--jobs" or option == "-j") {
+                jobs = value;
+            }
+            else if (option == "--slowest" or option == "-s") {
+                slowest = value;
+            }
+            else if (option == "--bench_time") {
+                bench_ms = value;
+            }
+            else {
+                threshold = value;
+            }
+        }
+        else if (argv[i] == std::string("--baseline") or
+                 argv[i] == std::string("--save_baseline")) {
+            if (i + 1 == argc) {
+                std::cout << "ERROR: " << argv[i] << " requires a filename"
+                          << std::endl;
+                throw ExitSuite(1);
+            }
+            (argv[i] == std::string("--baseline") ? baseline_file
+                                                  : save_file) = argv[i + 1];
+            ++i;
+        }
 #if UNIT_TEST_ENABLE_REGEXP
         else if (argv[i] == std::string("--regexp") or
                  argv[i] == std::string("-e")) {
@@ -570,9 +798,11 @@ std::vector<std::string> TestSuite::get_test_names_to_run(int argc,
                  argv[i] == std::string("-h")) {
             std::cout << "usage: " << argv[0]
 #if UNIT_TEST_ENABLE_REGEXP
-                      << " [-h] [-e] [-n] [-q] [[TEST_NAME] ...]\n";
+                      << " [-h] [-e] [-n] [-q] [-j N] [-s N]"
+                         " [benchmark options] [[TEST_NAME] ...]\n";
 #else
-                      << " [-h] [-n] [-q] [[TEST_NAME] ...]\n";
+                      << " [-h] [-n] [-q] [-j N] [-s N]"
+                         " [benchmark options] [[TEST_NAME] ...]\n";
 #endif
             std::cout
                 << "optional arguments:\n"
@@ -583,10 +813,22 @@ std::vector<std::string> TestSuite::get_test_names_to_run(int argc,
                 << " -n, --show_test_names\t print the names of all "
                    "discovered test cases and exit\n"
                 << " -q, --quiet\t\t print a reduced summary of test results\n"
-                << " TEST_NAME ...\t\t run only the test cases whose names "
-                   "are "
+                << " -j, --jobs N\t\t run up to N tests at once, each in its "
+                   "own process (output is still in order)\n"
+                << " -s, --slowest N\t report the N slowest tests and their "
+                   "times\n"
+                << " --bench_time MS\t run each benchmark for about MS "
+                   "milliseconds (default 500)\n"
+                << " --baseline FILE\t fail benchmarks that are slower than "
+                   "the means saved in FILE\n"
+                << " --threshold PCT\t percent slower than the baseline that "
+                   "fails (default 10)\n"
+                << " --save_baseline FILE\t save the benchmark means to FILE\n"
+                << " TEST_NAME ...\t\t run only the test cases (and "
+                   "benchmarks) whose names are "
                    "listed here. Note: If no test names are specified, all "
-                   "discovered tests are run by default."
+                   "discovered tests are run by default, followed by all "
+                   "benchmarks."
                 << std::endl;
 
             throw ExitSuite();
@@ -601,6 +843,10 @@ std::vector<std::string> TestSuite::get_test_names_to_run(int argc,
             std::begin(tests_), std::end(tests_),
             std::back_inserter(test_names_to_run),
             [](const std::pair<std::string, TestCase>& p) { return p.first; });
+        std::transform(
+            std::begin(benches_), std::end(benches_),
+            std::back_inserter(test_names_to_run),
+            [](const std::pair<std::string, BenchCase>& p) { return p.first; });
     }
 #if UNIT_TEST_ENABLE_REGEXP
     else if (regexp_matching) {
@@ -619,6 +865,11 @@ std::vector<std::string> TestSuite::get_test_names_to_run(int argc,
                 test_names_to_run.push_back(test_pair.first);
             }
         }
+        for (const auto& bench_pair : benches_) {
+            if (std::regex_match(bench_pair.first, name_regex)) {
+                test_names_to_run.push_back(bench_pair.first);
+            }
+        }
     }
 #endif
     return test_names_to_run;
@@ -628,6 +879,384 @@ std::ostream& operator<<(std::ostream& os, const TestFailure& test_failure) {
     return test_failure.print(os);
 }
 
+void TestSuite::print_slowest(const std::vector<std::string>& test_names) {
+    if (slowest <= 0) {
+        return;
+    }
+    std::vector<const TestCase*> cases;
+    for (const auto& test_name : test_names) {
+        cases.push_back(&tests_.at(test_name));
+    }
+    // stable, so that ties stay in the order the tests ran
+    std::stable_sort(cases.begin(), cases.end(),
+                     [](const TestCase* first, const TestCase* second) {
+                         return first->elapsed_ms > second->elapsed_ms;
+                     });
+    std::cout << "*** Slowest tests ***" << std::endl;
+    for (std::size_t i = 0; i < cases.size() and i < std::size_t(slowest);
+         ++i) {
+        std::ostringstream time;
+        time.setf(std::ios::fixed);
+        time.precision(3);
+        time << cases[i]->elapsed_ms;
+        std::cout << cases[i]->name << ": " << time.str() << " ms"
+                  << std::endl;
+    }
+}
+
+// Runs the benchmark once with an increasing number of iterations until
+// it takes at least target_ms / samples, then measures that many
+// iterations samples times.
+void BenchCase::run(bool quiet_mode, double target_ms, int samples) {
+    if (not quiet_mode) {
+        std::cout << "Running bench: " << name << std::endl;
+    }
+    try {
+        double target_ns = target_ms * 1e6 / samples;
+        for (iterations = 1;;) {
+            BenchState state(iterations);
+            bench_func(state);
+            if (state.elapsed_ns >= target_ns or iterations >= (1L << 40)) {
+                break;
+            }
+            // aim past the target, growing by between 2 and 10 times
+            double scale = 1.2 * target_ns / std::max(state.elapsed_ns, 1.0);
+            iterations *= std::max(2.0, std::min(10.0, scale));
+        }
+        for (int i = 0; i < samples; ++i) {
+            BenchState state(iterations);
+            bench_func(state);
+            sample_ns.push_back(state.elapsed_ns / iterations);
+            items_per_iteration = state.items_per_iteration;
+            bytes_per_iteration = state.bytes_per_iteration;
+        }
+    }
+    catch (TestFailure& failure) {
+        failure_msg = failure.to_string();
+    }
+    catch (std::exception& e) {
+        std::ostringstream oss;
+        oss << "Uncaught " << demangle(typeid(e).name()) << " in bench \""
+            << name << "\": \n";
+        oss << e.what() << '\n';
+        exception_msg = oss.str();
+    }
+    if (sample_ns.size() < std::size_t(samples)) {
+        sample_ns.clear();  // incomplete
+        return;
+    }
+    double sum = 0;
+    for (double time : sample_ns) {
+        sum += time;
+    }
+    mean_ns = sum / sample_ns.size();
+    double squares = 0;
+    for (double time : sample_ns) {
+        squares += (time - mean_ns) * (time - mean_ns);
+    }
+    stddev_ns = std::sqrt(squares / sample_ns.size());
+    std::sort(sample_ns.begin(), sample_ns.end());
+}
+
+// Returns the given percentile of the sample times, by nearest rank.
+double BenchCase::percentile_ns(double percent) const {
+    std::size_t rank = std::ceil(percent / 100 * sample_ns.size());
+    return sample_ns[std::max<std::size_t>(rank, 1) - 1];
+}
+
+// Formats the given amount with three significant digits and an SI
+// prefix for the given unit, such as "12.3 ms" or "4.56 GB/s".
+std::string format_amount(double amount, const char* unit, bool small) {
+    static const char* const large_prefixes[] = {"", "k", "M", "G", "T"};
+    static const char* const small_prefixes[] = {"n", "u", "m", ""};
+    const char* const* prefixes = (small ? small_prefixes : large_prefixes);
+    int count = (small ? 4 : 5);
+    int prefix = 0;
+    for (; prefix + 1 < count and std::abs(amount) >= 1000; ++prefix) {
+        amount /= 1000;
+    }
+    std::ostringstream oss;
+    oss.precision(3);
+    oss << amount << ' ' << prefixes[prefix] << unit;
+    return oss.str();
+}
+
+void BenchCase::print(bool quiet_mode) {
+    std::string result = (not failure_msg.empty() ? "FAIL"
+                          : not exception_msg.empty() ? "ERROR"
+                                                      : "PASS");
+    if (quiet_mode) {
+        std::cout << name << ": " << result;
+        if (not sample_ns.empty()) {
+            std::cout << " (mean " << format_amount(mean_ns, "s", true) << ")";
+        }
+        std::cout << std::endl;
+        return;
+    }
+    std::cout << "** Bench \"" << name << "\": " << result << std::endl;
+    if (not sample_ns.empty()) {
+        std::cout << "   mean " << format_amount(mean_ns, "s", true)
+                  << ", stddev " << format_amount(stddev_ns, "s", true)
+                  << ", p50 " << format_amount(percentile_ns(50), "s", true)
+                  << ", p90 " << format_amount(percentile_ns(90), "s", true)
+                  << ", p99 " << format_amount(percentile_ns(99), "s", true)
+                  << " per iteration\n   (" << sample_ns.size()
+                  << " samples of " << iterations << " iterations)";
+        if (items_per_iteration > 0) {
+            std::cout << ", "
+                      << format_amount(items_per_iteration * 1e9 / mean_ns,
+                                       "items/s", false);
+        }
+        if (bytes_per_iteration > 0) {
+            std::cout << ", "
+                      << format_amount(bytes_per_iteration * 1e9 / mean_ns,
+                                       "B/s", false);
+        }
+        if (baseline_ns > 0) {
+            std::ostringstream change;
+            change.setf(std::ios::fixed | std::ios::showpos);
+            change.precision(1);
+            change << 100 * (mean_ns / baseline_ns - 1);
+            std::cout << ", baseline " << format_amount(baseline_ns, "s", true)
+                      << " (" << change.str() << "%)";
+        }
+        std::cout << std::endl;
+    }
+    if (not failure_msg.empty()) {
+        std::cout << failure_msg << std::endl;
+    }
+    if (not exception_msg.empty()) {
+        std::cout << exception_msg << std::endl;
+    }
+}
+
+// Runs the given benchmarks one at a time, after the tests, comparing
+// each against the baseline file if there is one. Returns the exit
+// status of the suite: 1 if any benchmark failed or regressed.
+int TestSuite::run_benches(const std::vector<std::string>& bench_names) {
+    if (bench_names.empty()) {
+        return 0;
+    }
+    std::map<std::string, double> baseline;
+    if (not baseline_file.empty()) {
+        std::ifstream input(baseline_file);
+        if (not input) {
+            std::cout << "ERROR: Unable to read baseline " << baseline_file
+                      << std::endl;
+            return 1;
+        }
+        std::string name;
+        double mean = 0;
+        while (input >> name >> mean) {
+            baseline[name] = mean;
+        }
+    }
+
+    for (const auto& bench_name : bench_names) {
+        BenchCase& bench = benches_.at(bench_name);
+        bench.run(quiet_mode, bench_ms, bench_samples);
+        auto found = baseline.find(bench_name);
+        if (found == baseline.end() or bench.sample_ns.empty()) {
+            continue;
+        }
+        bench.baseline_ns = found->second;
+        if (bench.mean_ns > bench.baseline_ns * (1 + threshold / 100)) {
+            std::ostringstream reason;
+            reason << "Regressed: more than " << threshold
+                   << "% slower than the baseline";
+            bench.failure_msg = reason.str();
+        }
+    }
+
+    std::cout << "\n*** Benchmarks ***" << std::endl;
+    int num_failures = 0;
+    int num_errors = 0;
+    for (const auto& bench_name : bench_names) {
+        BenchCase& bench = benches_.at(bench_name);
+        bench.print(quiet_mode);
+        num_failures += not bench.failure_msg.empty();
+        num_errors += not bench.exception_msg.empty();
+    }
+
+    if (not save_file.empty()) {
+        std::ofstream output(save_file);
+        output.precision(17);
+        for (const auto& bench_name : bench_names) {
+            const BenchCase& bench = benches_.at(bench_name);
+            if (not bench.sample_ns.empty()) {
+                output << bench_name << ' ' << bench.mean_ns << '\n';
+            }
+        }
+        if (not output) {
+            std::cout << "ERROR: Unable to save baseline " << save_file
+                      << std::endl;
+            ++num_errors;
+        }
+    }
+
+    if (not quiet_mode) {
+        std::cout << "*** Summary ***" << std::endl;
+        std::cout << "Out of " << bench_names.size()
+                  << " benchmarks run:" << std::endl;
+        std::cout << num_failures << " failure(s), " << num_errors
+                  << " error(s)" << std::endl;
+    }
+    return num_failures == 0 and num_errors == 0 ? 0 : 1;
+}
+
+#if UNIT_TEST_ENABLE_FORK
+// Runs each of the given tests in a child process, with up to jobs of
+// them at a time. A child sends its output and its result back through
+// pipes, and the output of each test is printed once the tests before
+// it are done, so it appears in the same order as a serial run. A test
+// that crashes fails with an error rather than stopping the suite.
+void TestSuite::run_forked(const std::vector<std::string>& test_names) {
+    struct Child {
+        pid_t pid = -1;
+        int output_fd = -1;  // the child's stdout and stderr
+        int result_fd = -1;  // the child's elapsed time and messages
+        std::string output;
+        std::string result;
+        bool done = false;
+    };
+    std::vector<Child> children(test_names.size());
+    std::size_t next_to_start = 0;
+    std::size_t next_to_print = 0;
+    int running = 0;
+
+    while (next_to_print < test_names.size()) {
+        while (running < jobs and next_to_start < test_names.size()) {
+            Child& child = children[next_to_start];
+            TestCase& test = tests_.at(test_names[next_to_start]);
+            int output_pipe[2];
+            int result_pipe[2];
+            std::cout << std::flush;
+            std::fflush(stdout);
+            if (pipe(output_pipe) != 0 or pipe(result_pipe) != 0 or
+                (child.pid = fork()) < 0) {
+                throw std::runtime_error("Unable to start a test process");
+            }
+            if (child.pid == 0) {  // in the child
+                close(output_pipe[0]);
+                close(result_pipe[0]);
+                dup2(output_pipe[1], STDOUT_FILENO);
+                dup2(output_pipe[1], STDERR_FILENO);
+                close(output_pipe[1]);
+                test.run(quiet_mode);
+                std::cout << std::flush;
+                std::ostringstream result;
+                result << test.elapsed_ms << '\n'
+                       << test.failure_msg.size() << '\n' << test.failure_msg
+                       << test.exception_msg.size() << '\n'
+                       << test.exception_msg;
+                std::string data = result.str();
+                for (std::size_t sent = 0; sent < data.size();) {
+                    ssize_t written = write(result_pipe[1], data.data() + sent,
+                                            data.size() - sent);
+                    if (written <= 0) {
+                        break;
+                    }
+                    sent += written;
+                }
+                _exit(0);  // skip the exit handlers, which belong to the parent
+            }
+            close(output_pipe[1]);
+            close(result_pipe[1]);
+            child.output_fd = output_pipe[0];
+            child.result_fd = result_pipe[0];
+            ++running;
+            ++next_to_start;
+        }
+
+        // wait for output from any running child, reading it so that
+        // none of them blocks on a full pipe
+        std::vector<pollfd> fds;
+        std::vector<std::pair<Child*, bool>> sources;  // (child, is output)
+        for (std::size_t i = next_to_print; i < next_to_start; ++i) {
+            Child& child = children[i];
+            if (child.output_fd >= 0) {
+                fds.push_back({child.output_fd, POLLIN, 0});
+                sources.push_back({&child, true});
+            }
+            if (child.result_fd >= 0) {
+                fds.push_back({child.result_fd, POLLIN, 0});
+                sources.push_back({&child, false});
+            }
+        }
+        if (not fds.empty() and poll(fds.data(), fds.size(), -1) < 0) {
+            continue;  // interrupted
+        }
+        for (std::size_t i = 0; i < fds.size(); ++i) {
+            if (fds[i].revents == 0) {
+                continue;
+            }
+            Child& child = *sources[i].first;
+            int& fd = (sources[i].second ? child.output_fd : child.result_fd);
+            std::string& data =
+                (sources[i].second ? child.output : child.result);
+            char buffer[4096];
+            ssize_t count = read(fd, buffer, sizeof(buffer));
+            if (count > 0) {
+                data.append(buffer, count);
+            }
+            else {
+                close(fd);
+                fd = -1;
+            }
+        }
+
+        // collect children that have closed both pipes
+        for (std::size_t i = next_to_print; i < next_to_start; ++i) {
+            Child& child = children[i];
+            if (child.done or child.output_fd >= 0 or child.result_fd >= 0) {
+                continue;
+            }
+            int status = 0;
+            waitpid(child.pid, &status, 0);
+            child.done = true;
+            --running;
+            TestCase& test = tests_.at(test_names[i]);
+            std::istringstream result(child.result);
+            std::size_t failure_size = 0;
+            std::size_t exception_size = 0;
+            if (WIFEXITED(status) and WEXITSTATUS(status) == 0 and
+                result >> test.elapsed_ms >> failure_size and
+                result.ignore()) {
+                test.failure_msg.resize(failure_size);
+                result.read(&test.failure_msg[0], failure_size);
+                result >> exception_size;
+                result.ignore();
+                test.exception_msg.resize(exception_size);
+                result.read(&test.exception_msg[0], exception_size);
+            }
+            else {
+                std::ostringstream oss;
+                oss << "Test process for \"" << test.name << "\" ";
+                if (WIFSIGNALED(status)) {
+                    oss << "was killed by signal " << WTERMSIG(status) << " ("
+                        << strsignal(WTERMSIG(status)) << ")\n";
+                }
+                else {
+                    oss << "exited with status " << WEXITSTATUS(status)
+                        << '\n';
+                }
+                test.exception_msg = oss.str();
+                if (not quiet_mode) {
+                    child.output += "ERROR\n";
+                }
+            }
+        }
+
+        // print output in order, as far as the tests are done
+        for (; next_to_print < next_to_start and children[next_to_print].done;
+             ++next_to_print) {
+            std::cout << children[next_to_print].output << std::flush;
+            std::string().swap(children[next_to_print].output);
+        }
+    }
+}
+#endif  // UNIT_TEST_ENABLE_FORK
+
 //------------------------------------------------------------------------------
 
 #if defined(__clang__) || defined(__GLIBCXX__) || defined(__GLIBCPP__)
@@ -686,4 +1315,42 @@ void assert_almost_equal(double first, double second, double precision,
     throw TestFailure(reason.str(), line_number, assertion_text);
 }
 
+//------------------------------------------------------------------------------
+
+#if UNIT_TEST_COUNT_ALLOCATIONS
+static std::atomic<long> allocations_made{0};
+
+// Returns the number of calls to operator new so far.
+long allocation_count() {
+    return allocations_made;
+}
+
+void* operator new(std::size_t size) {
+    ++allocations_made;
+    if (void* memory = std::malloc(size > 0 ? size : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+void assert_allocations_at_most(long allocations, long budget,
+                                int line_number, const char* assertion_text) {
+    if (allocations <= budget) {
+        return;
+    }
+    std::ostringstream reason;
+    reason << "Made " << allocations << " allocations, over the budget of "
+           << budget;
+    throw TestFailure(reason.str(), line_number, assertion_text);
+}
+#endif  // UNIT_TEST_COUNT_ALLOCATIONS
+
 #endif  // UNIT_TEST_FRAMEWORK_HPP